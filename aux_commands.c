@@ -45,7 +45,7 @@ int readBuffer(char *buffer, char *name, int *d1) {
   return result;
 }
 /**
- * @brief Validates the exit of a vehicle from a park for command S.
+ * @brief Validates the exit of a vehicle from a park.
  *
  * This function checks various conditions to determine if a vehicle can exit a
  * park. It checks if the park exists, if the license plate is valid, if the
@@ -53,32 +53,27 @@ int readBuffer(char *buffer, char *name, int *d1) {
  * the entry date and time.
  *
  * @param m Pointer to the Memory structure.
- * @param p1 Pointer to the Park structure.
- * @param r1 Pointer to the Record structure.
- * @param name Name of the park.
- * @param plates License plate of the vehicle.
- * @param date Date of exit.
- * @param time Time of exit.
- * @return Returns 1 if all validations pass and the vehicle can exit,
- * otherwise returns 0 and prints an error message.
+ * @param p1 Pointer to the Park structure, or NULL.
+ * @param plate The encoded license plate of the vehicle.
+ * @param now The date and time of the exit.
+ * @return Returns ST_OK if all validations pass and the vehicle can exit,
+ * otherwise returns the status of the first validation that failed.
  */
-int validationsS(Memory *m, Park *p1, Record *r1, char *name, char *plates,
-                 char *date, char *time) {
+int checkExit(Memory *m, Park *p1, Plate plate, Stamp now) {
+  Record *r1 = getLastRecord(m->cars, plate);
   if (!p1) {
     // checking if park exists
-    printf(ERR_PARK_NOT_FOUND(name));
-  } else if (checkPlates(plates) == 0) {
+    return ST_PARK_NOT_FOUND;
+  } else if (!checkPlateCode(plate)) {
     // checking if license is valid
-    printf(ERR_INVALID_LICENSE(plates));
-  } else if (!r1 || r1->park->id != p1->id || r1->exitDay != NO_DATE) {
-    printf(ERR_INVALID_EXIT(plates));
-  } else if (!checkDates(m, date, time)) {
+    return ST_INVALID_LICENSE;
+  } else if (!r1 || r1->park != p1->index || r1->exit != NO_STAMP) {
+    return ST_INVALID_EXIT;
+  } else if (!checkStamp(m, now)) {
     // checking if date is valid and if date is after entry
-    printf(ERR_INVALID_DATE);
-  } else {
-    return 1;
+    return ST_INVALID_DATE;
   }
-  return 0;
+  return ST_OK;
 }
 /**
  * @brief Validates the creation of a new park for command P.
@@ -89,31 +84,29 @@ int validationsS(Memory *m, Park *p1, Record *r1, char *name, char *plates,
  *
  * @param m Pointer to the Memory structure.
  * @param p1 Pointer to the Park structure.
- * @return Returns 1 if all validations pass and the park can be created,
- * otherwise returns 0 and prints an error message.
+ * @return Returns ST_OK if all validations pass, otherwise returns the status
+ * of the first validation that failed.
  */
-int validationsP(Memory *m, Park *p1) {
-  if (listGetPark(m->parks, p1->name)) {
+int checkPark(Memory *m, Park *p1) {
+  if (getPark(m, p1->name)) {
     // checking if park already exists
-    printf(ERR_PARK_ALREADY_EXISTS(p1->name));
+    return ST_PARK_EXISTS;
   } else if (p1->capacity <= 0) {
     // checking if capacity is valid
-    printf(ERR_INVALID_CAPACITY(p1->capacity));
+    return ST_INVALID_CAPACITY;
   } else if (p1->less_60 <= 0 || p1->more_60 < p1->less_60 ||
              p1->dayly < p1->more_60) {
     // checking if costs are correct
-    printf(ERR_INVALID_COST);
+    return ST_INVALID_COST;
   } else if (m->parks->size == MAX_PARKS) {
     // checking if there are too many parks
-    printf(ERR_TOO_MANY_PARKS);
-  } else {
-    return 1;
+    return ST_TOO_MANY_PARKS;
   }
-  return 0;
+  return ST_OK;
 }
 
 /**
- * @brief Validates the entry of a vehicle into a park for command E.
+ * @brief Validates the entry of a vehicle into a park.
  *
  * This function checks various conditions to determine if a vehicle can enter
  * a park. It checks if the park exists, if the park is full, if the license
@@ -121,35 +114,29 @@ int validationsP(Memory *m, Park *p1) {
  * time are valid.
  *
  * @param m Pointer to the Memory structure.
- * @param p1 Pointer to the Park structure.
- * @param r1 Pointer to the Record structure.
- * @param name Name of the park.
- * @param plates License plate of the vehicle.
- * @param date Date of entry.
- * @param data Date string.
- * @param time Time of entry.
- * @return Returns 1 if all validations pass, otherwise returns 0 and prints a
- * error message.
+ * @param p1 Pointer to the Park structure, or NULL.
+ * @param plate The encoded license plate of the vehicle.
+ * @param now The date and time of the entry.
+ * @return Returns ST_OK if all validations pass, otherwise returns the status
+ * of the first validation that failed.
  */
-int validationsE(Memory *m, Park *p1, Record *r1, char *name, char *plates,
-                 char *data, char *time) {
+int checkEntry(Memory *m, Park *p1, Plate plate, Stamp now) {
+  Record *r1 = getLastRecord(m->cars, plate);
   if (!p1) {
     // checking if park exists
-    printf(ERR_PARK_NOT_FOUND(name));
+    return ST_PARK_NOT_FOUND;
   } else if (p1->occupancy >= p1->capacity) {
     // checking if park is full
-    printf(ERR_FULL_PARK(name));
-  } else if (!checkPlates(plates)) {
+    return ST_FULL_PARK;
+  } else if (!checkPlateCode(plate)) {
     // checking if license Plate is rightformat
-    printf(ERR_INVALID_LICENSE(plates));
-  } else if (r1 && r1->exitDay == NO_DATE) {
+    return ST_INVALID_LICENSE;
+  } else if (r1 && r1->exit == NO_STAMP) {
     // checking if vehicle is another park
-    printf(ERR_INVALID_ENTRY(plates));
-  } else if (!checkDates(m, data, time)) {
+    return ST_INVALID_ENTRY;
+  } else if (!checkStamp(m, now)) {
     // checking if date is correct
-    printf(ERR_INVALID_DATE);
-  } else {
-    return 1;
+    return ST_INVALID_DATE;
   }
-  return 0;
+  return ST_OK;
 }
@@ -37,7 +37,7 @@ void readLine(char buffer[]) {
   buffer[index] = '\0';
 }
 
-static void addSumNode(Node *recordNode, List *dates) {
+static void addSumNode(Park *p, Node *recordNode, List *dates) {
   Node *newdatesNode = malloc(sizeof(Node));
   newdatesNode->item.dateSum = malloc(sizeof(DateSum));
   newdatesNode->next = NULL;
@@ -49,13 +49,15 @@ static void addSumNode(Node *recordNode, List *dates) {
     dates->tail->next = newdatesNode;
     dates->tail = newdatesNode;
   }
-  newdatesNode->item.dateSum->exitDay = recordNode->item.record->exitDay;
-  newdatesNode->item.dateSum->charged += recordNode->item.record->paid;
+  newdatesNode->item.dateSum->exitDay =
+      STAMP_DAY(recordNode->item.record->exit);
+  newdatesNode->item.dateSum->charged +=
+      calculatePrice(p, recordNode->item.record);
   dates->size++;
 }
 
 static int dateExists(Node *record, Node *date) {
-  return record->item.record->exitDay - date->item.dateSum->exitDay == 0;
+  return STAMP_DAY(record->item.record->exit) == date->item.dateSum->exitDay;
 }
 
 /**
@@ -70,24 +72,26 @@ static int dateExists(Node *record, Node *date) {
  * charged for that day. If no such record exists, a new date sum item is
  * created and added to the list.
  *
- * @param records A pointer to the list of records.
+ * @param p A pointer to the park, whose list of records is used.
  * @return Returns a pointer to the list of date sum items.
  */
 
-List *calculateSums(List *records) {
+List *calculateSums(Park *p) {
+  List *records = p->records;
   List *dates = ListNew();  // initializes all fields of List
   Node *recordNode = records->head;
+  long span = traceBegin();
   int found = 0;
   for (int i = 0; i < records->size; i++) {
     // Looping through parks records
-    if (recordNode->item.record->exitDay != NO_TIME) {
+    if (recordNode->item.record->exit != NO_STAMP) {
       // Checking if vehicle has left the park
       Node *datesNode = dates->head;
       for (int j = 0; j < dates->size; j++) {
         // Looping through dates records checking if date already exists
         if (dateExists(recordNode, datesNode)) {
-          datesNode->item.dateSum->exitDay = recordNode->item.record->exitDay;
-          datesNode->item.dateSum->charged += recordNode->item.record->paid;
+          datesNode->item.dateSum->charged +=
+              calculatePrice(p, recordNode->item.record);
           found = 1;
           break;
         }
@@ -95,36 +99,54 @@ List *calculateSums(List *records) {
       }
       if (found == 0) {
         // No date record found, creating new one
-        addSumNode(recordNode, dates);
+        addSumNode(p, recordNode, dates);
       }
     }
     found = 0;
     recordNode = recordNode->next;
   }
+  traceEnd("calculateSums", span);
   return dates;
 }
 /**
  * @brief Updates the current date and time in the Memory structure.
  *
  * This function updates the current date and time in the Memory structure. The
- * date and time are stored as integers in the format yyyymmdd and hhmm,
- * respectively.
+ * date and time are stored as a single Stamp, the number of minutes since
+ * 01-01-0000 00:00. The clock only moves forward, with a compare and swap, so
+ * entries and exits at many gates at once agree on the order of the changes.
+ * The timer wheel, if there is one, is moved forward with it, so the vehicles
+ * that overstay are found as the clock passes their minute.
  *
  * @param m A pointer to the Memory structure to be updated.
- * @param date The new date.
- * @param time The new time.
+ * @param now The new date and time.
+ * @return Returns 1, or 0 if the clock was already past `now`.
  */
-void updateMemoryTime(Memory *m, int date, int time) {
-  m->date = date;
-  m->time = time;
+int updateMemoryTime(Memory *m, Stamp now) {
+  Stamp last = atomic_load_explicit(&m->now, memory_order_relaxed);
+  do {
+    if (now < last) {
+      return 0;
+    }
+  } while (!atomic_compare_exchange_weak(&m->now, &last, now));
+  if (m->wheel) {
+    wheelAdvance(m, now);
+  }
+  return 1;
 }
 /**
  * @brief Initializes the system.
  *
  * This function initializes the system by creating a new list of parks, a new
- * hash table for cars, and setting the current date and time to 0. It also
+ * hash table for cars, an empty park table, pool of park names and slabs of
+ * records, nodes, vehicles and lists, and setting
+ * the current date and
+ * time to NO_STAMP. It also
  * sets the ID incrementer to 1, which is used to assign unique IDs to new
- * parks.
+ * parks. The network rankings and the summary start empty, every result is
+ * printed, no event ring is written, every record is kept and no overstay
+ * is detected. The locks of the hash table, of the
+ * vehicles and of the network are created.
  *
  * @param m A pointer to the Memory structure to be initialized.
  */
@@ -133,9 +155,51 @@ void initializeSystem(Memory *m) {
   HashTable *h = malloc(sizeof(HashTable));
   m->cars = h;
   initializeHashTable(h);
-  m->date = 0;
-  m->time = 0;
+  slabInit(&m->records, sizeof(Record));
+  slabInit(&m->nodes, sizeof(Node));
+  slabInit(&m->vehicles, sizeof(HashNode));
+  slabInit(&m->lists, sizeof(List));
+  m->now = NO_STAMP;
+  m->closed = 0;
+  pthread_rwlock_init(&m->table, NULL);
+  m->stripes = aligned_alloc(CACHE_LINE, sizeof(Stripe) * PLATE_STRIPES);
+  for (int i = 0; i < PLATE_STRIPES; i++) {
+    pthread_mutex_init(&m->stripes[i].lock, NULL);
+  }
+  pthread_mutex_init(&m->lock, NULL);
   m->idIncrementer = 1;
+  m->names.chars = NULL;
+  m->names.size = 0;
+  m->names.capacity = 0;
+  for (int i = 0; i < MAX_PARKS; i++) {
+    m->parkTable[i] = NULL;
+  }
+  topKInit(&m->top[RANK_SPEND], RANK_SPEND);
+  topKInit(&m->top[RANK_VISITS], RANK_VISITS);
+  m->output = OUTPUT_ALL;
+  m->out = stdout;
+  memset(&m->summary, 0, sizeof(Summary));
+  m->events = NULL;
+  m->keepRecords = 0;
+  m->keepDays = 0;
+  m->wheel = NULL;
+  m->imported = NULL;
+}
+
+/**
+ * @brief Reserves space for an expected number of records.
+ *
+ * The slab of the records, the slab of the nodes that list them, by vehicle
+ * and by park, and the hash table are sized at once, so that a large history
+ * is stored in a few large mappings instead of growing into many.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param records The expected number of records.
+ */
+void expectRecords(Memory *m, long records) {
+  slabReserve(&m->records, records);
+  slabReserve(&m->nodes, records * 2);
+  hashReserve(m->cars, records);
 }
 /**
  * @brief Checks the validity of a license plate.
@@ -167,6 +231,87 @@ int checkPlates(char *l) {
   }
   return 0;  // License plate is not formatted correctly
 }
+/**
+ * @brief Encodes a pair of characters of a license plate.
+ *
+ * Pairs of digits are encoded from 0 to 99 and pairs of letters from 100 to
+ * 775, so that the codes follow the lexicographic order of the pairs.
+ *
+ * @param c The pair of characters.
+ * @return Returns the code of the pair, which fits in 10 bits.
+ */
+static Plate encodePair(char *c) {
+  if (isdigit(c[0])) {
+    return (c[0] - '0') * 10 + (c[1] - '0');
+  }
+  return 100 + (c[0] - 'A') * 26 + (c[1] - 'A');
+}
+
+/**
+ * @brief Decodes a pair of characters of a license plate.
+ *
+ * @param code The code of the pair.
+ * @param c The buffer into which the pair of characters is written.
+ */
+static void decodePair(Plate code, char *c) {
+  if (code < 100) {
+    c[0] = '0' + code / 10;
+    c[1] = '0' + code % 10;
+  } else {
+    c[0] = 'A' + (code - 100) / 26;
+    c[1] = 'A' + (code - 100) % 26;
+  }
+}
+
+/**
+ * @brief Encodes a license plate into an integer.
+ *
+ * Each of the three pairs of the license plate is encoded in 10 bits, the
+ * first pair in the highest bits, so comparing two encoded license plates is
+ * the same as comparing them as strings.
+ *
+ * @param l The license plate to be encoded.
+ * @return Returns the encoded license plate, or NO_PLATE if the license plate
+ * is not valid.
+ */
+Plate encodePlate(char *l) {
+  if (!checkPlates(l)) {
+    return NO_PLATE;
+  }
+  return encodePair(l) << 20 | encodePair(l + 3) << 10 | encodePair(l + 6);
+}
+
+/**
+ * @brief Decodes a license plate into a string.
+ *
+ * @param plate The encoded license plate.
+ * @param l The buffer into which the license plate is written, with room for
+ * at least 9 characters.
+ */
+void decodePlate(Plate plate, char *l) {
+  decodePair(plate >> 20 & 0x3FF, l);
+  decodePair(plate >> 10 & 0x3FF, l + 3);
+  decodePair(plate & 0x3FF, l + 6);
+  l[2] = l[5] = '-';
+  l[8] = '\0';
+}
+
+/**
+ * @brief Checks the validity of an encoded license plate.
+ *
+ * @param plate The encoded license plate.
+ * @return Returns 1 if the code is that of a valid license plate, or 0 if it
+ * is not.
+ */
+int checkPlateCode(Plate plate) {
+  char plates[9];
+  if (plate == NO_PLATE) {
+    return 0;
+  }
+  decodePlate(plate, plates);
+  return encodePlate(plates) == plate;
+}
+
 /**
  * @brief Retrieves the number of days in a given month.
  *
@@ -202,25 +347,39 @@ static int sumDaysAllMonths(int month) {
   }
   return days;
 }
+/**
+ * @brief Converts the parts of a date to the number of days since 01-01-0000.
+ *
+ * The day must be between 1 and the number of days in the month, the month
+ * must be between 1 and 12, and the year must be between 0 and MAX_YEAR.
+ *
+ * @param day The day of the month.
+ * @param month The month, January is 1.
+ * @param year The year.
+ * @return Returns the date as an integer, as `dateToInt`, or -1 if the date
+ * is not valid.
+ */
+int dateFromParts(int day, int month, int year) {
+  if (month < 1 || month > 12 || day < 1 || day > getDaysOfMonth(month) ||
+      year < 0 || year > MAX_YEAR) {
+    return -1;
+  }
+  return year * 365 + sumDaysAllMonths(month) + day;
+}
 /**
  * @brief Checks the validity of a date.
  *
  * This function checks the validity of a date. A valid date has the format
- * dd-mm-yyyy, where dd is the day, mm is the month, and yyyy is the year.
- * The day must be between 1 and the number of days in the month, the month
- * must be between 1 and 12, and the year must be 2024 or later.
+ * dd-mm-yyyy, where dd is the day, mm is the month, and yyyy is the year, and
+ * its parts are accepted by `dateFromParts`.
  *
  * @param date The date to be checked.
  * @return Returns 1 if the date is valid, or 0 if it is not.
  */
 int checkDateFormat(char *date) {
-  int day, month, year;
+  int day = 0, month = 0, year = 0;
   sscanf(date, "%d-%d-%d", &day, &month, &year);
-  if (day < 1 || day > getDaysOfMonth(month) || month < 1 || month > 12 ||
-      year < 0) {
-    return 0;
-  }
-  return 1;
+  return dateFromParts(day, month, year) >= 0;
 }
 /**
  * @brief Checks the validity of a time.
@@ -232,7 +391,7 @@ int checkDateFormat(char *date) {
  * @param time The time to be checked.
  * @return Returns 1 if the time is valid, or 0 if it is not.
  */
-static int checkTimeFormat(char *time) {
+int checkTimeFormat(char *time) {
   int hours, minutes;
   sscanf(time, "%d:%d", &hours, &minutes);
   if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
@@ -244,98 +403,92 @@ static int checkTimeFormat(char *time) {
  * @brief Checks if a given date and time is in the past.
  *
  * This function checks if a given date and time is in the past relative to
- * the current date and time stored in the Memory structure. If the current
- * date is NO_DATE (which represents an unset date), the function returns 0.
- * If the given date is less than the current date, or if the given date is
- * the same as the current date but the given time is less than or equal to
- * the current time, the function returns 0. Otherwise, it returns 1.
+ * the current date and time stored in the Memory structure. Both are
+ * Stamps, so this is a single comparison. An unset current date is NO_STAMP,
+ * which is never after a valid date.
  *
  * @param m A pointer to the Memory structure that contains the current date
  * and time.
- * @param date The date to be checked.
- * @param time The time to be checked.
+ * @param stamp The date and time to be checked.
  * @return Returns 0 if the given date and time is not in the past, or 1 if
  * it is.
  */
-static int dateInPast(Memory *m, int date, int time) {
-  if (m->date == NO_DATE) {
-    return 0;
-  } else if (m->date < date) {
-    return 0;
-  } else if (m->date == date && m->time <= time) {
-    return 0;
+static int dateInPast(Memory *m, Stamp stamp) { return m->now > stamp; }
+/**
+ * @brief Converts a date and a time to a Stamp.
+ *
+ * @param date The date, in the format dd-mm-yyyy.
+ * @param time The time, in the format hh:mm.
+ * @return Returns the date and time as a Stamp, or NO_STAMP if they are not
+ * valid.
+ */
+Stamp parseStamp(char *date, char *time) {
+  if (checkDateFormat(date) == 0 || checkTimeFormat(time) == 0) {
+    return NO_STAMP;
   }
-  return 1;
+  return STAMP(dateToInt(date), timeToInt(time));
 }
 /**
  * @brief Checks the validity of a date and time and whether they are in the
  * past.
  *
- * This function checks the validity of a date and time and whether they are
- * in the past relative to the current date and time stored in the Memory
- * structure. It first checks if the date and time are in the correct format.
- * If they are not, the function returns 1. Then it converts the date and
- * time to integers and checks if they are in the past. If they are in the
- * past, the function returns 1. Otherwise, it returns 0.
+ * This function checks that a Stamp is a valid date and time, up to the end
+ * of MAX_YEAR, and that it is not in the past relative to the current date
+ * and time stored in the Memory structure.
  *
  * @param m A pointer to the Memory structure that contains the current date
  * and time.
- * @param date2 The date to be checked.
- * @param time2 The time to be checked.
- * @return Returns 1 if the date and time are not valid or are in the past,
- * or 0 if they are valid and not in the past.
+ * @param stamp The date and time to be checked.
+ * @return Returns 1 if the date and time are valid and not in the past, or 0
+ * if they are not valid or are in the past.
  */
-int checkDates(Memory *m, char *date2, char *time2) {
-  // Checking if days, months, years are compatible values
-  if (checkDateFormat(date2) == 0 || checkTimeFormat(time2) == 0) {
-    return 0;
-  } else {
-    int date = dateToInt(date2);
-    int time = timeToInt(time2);
-    if (dateInPast(m, date, time)) {
-      return 0;
-    }
-  }
-  return 1;
+int checkStamp(Memory *m, Stamp stamp) {
+  return stamp != NO_STAMP && stamp <= LAST_STAMP && !dateInPast(m, stamp);
 }
 
+/**
+ * @brief Converts an amount of money to cents.
+ *
+ * @param value The amount of money, in euros.
+ * @return Returns the amount of money rounded to the nearest cent.
+ */
+Cents toCents(float value) { return (Cents)(value * 100 + 0.5f); }
+
 /**
  * @brief Calculates the price for a parking record.
  *
  * This function calculates the price for a parking record. The price is
  * calculated based on the number of days and minutes the car was parked. The
- * price is calculated in blocks of 15 minutes. If the exit hour is earlier
- * than the entry hour, it is assumed that the car was parked for an
- * additional day.
+ * price is calculated in blocks of 15 minutes. The amount is not stored in the
+ * record, so it is calculated whenever it is needed.
  *
+ * @param p A pointer to the Park structure of the record.
  * @param r A pointer to the Record structure for which the price is to be
  * calculated.
+ * @return Returns the price of the stay, in cents.
  */
-void calculatePrice(Record *r) {
+Cents calculatePrice(Park *p, Record *r) {
   // Temporary placeholder for price of parking
-  float price = 0;
+  Cents price = 0;
   // Temporary placeholders for auxiliary calculations
-  int total, days, minutes, blocks;
-  // Converting days into minutes and adding to minutes
-  total = (r->exitDay - r->entryDay) * 24 * 60 + r->exitHour - r->entryHour;
+  Stamp total, days, minutes, blocks;
+  // Minutes between entry and exit
+  total = r->exit - r->entry;
   // Calculating how many days of parking (24 hours)
-  days = total / 1440;
+  days = total / MINUTES_PER_DAY;
   // Calculating how many minutes passed days
-  minutes = total % 1440;
-  // Calculating how many blocks of 15 minutes
-  blocks = minutes / 15;
-  // Ceiling the blocks calculation
-  if (minutes % 15 != 0) blocks++;
+  minutes = total % MINUTES_PER_DAY;
+  // Calculating how many blocks of 15 minutes, ceiling the calculation
+  blocks = (minutes + 14) / 15;
   // Checking if blocks are more then 4, price changes
   if (blocks > 4) {
-    price = 4 * r->park->less_60 + (blocks - 4) * r->park->more_60;
+    price = 4 * p->less_60 + (blocks - 4) * p->more_60;
   } else {
-    price = blocks * r->park->less_60;
+    price = blocks * p->less_60;
   }
   // Checking if price is higher the daily fee.
-  price = price >= r->park->dayly ? r->park->dayly : price;
-  // Adding to record the correct price.
-  r->paid = days * r->park->dayly + price;
+  price = price >= p->dayly ? p->dayly : price;
+  return days * p->dayly + price;
 }
 
 /**
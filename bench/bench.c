@@ -0,0 +1,681 @@
+/**
+ * @file bench.c
+ * @brief Microbenchmarks of the core functions of the program.
+ *
+ * Runs each kernel over inputs generated from a seed, first a few untimed
+ * warmup rounds and then the timed rounds, and writes one CSV line per
+ * kernel to stdout: the nanoseconds per operation, their mean, standard
+ * deviation and minimum over the rounds, and the operations per second of
+ * the mean. The same seed and size always give the same inputs, so the lines
+ * of two commits can be compared, and with -b the mean of a previous run is
+ * added to each line, with the change from it.
+ *
+ * Options:
+ *   -n <size>      operations per round of each kernel (default 100000)
+ *   -r <rounds>    timed rounds (default 10)
+ *   -w <rounds>    warmup rounds (default 2)
+ *   -s <seed>      seed of the inputs (default 1)
+ *   -k <name>      runs only the kernels whose name contains it
+ *   -b <file.csv>  compares with the results of a previous run
+ *
+ * Usage:
+ *   bench -n 200000 > before.csv
+ *   bench -n 200000 -b before.csv
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "project.h"
+
+#define BENCH_PARKS 20         /*Parks of the kernels that need a system*/
+#define BENCH_STAYS 64         /*Records of each vehicle sorted by sortRecords*/
+#define BENCH_DAYS 365         /*Days over which the billed exits are spread*/
+#define BENCH_FIRST_DAY 730000 /*First day of the generated dates, in 1999*/
+#define BENCH_GATES 4          /*Threads entering and exiting vehicles at once*/
+
+/**
+ * @brief Structure to hold the inputs of the kernels.
+ *
+ * @param size The number of operations of each round.
+ * @param plates License plates, as text.
+ * @param codes The same license plates, encoded.
+ * @param order A permutation of 0 to size - 1, to look the plates up.
+ * @param dates Dates, as text.
+ * @param times Times, as text.
+ * @param days The same dates, as days.
+ * @param minutes The same times, as minutes.
+ * @param stays Closed records of random length, to be priced.
+ * @param m The system a kernel works on, or NULL.
+ * @param records Records to be added by the kernel of `addRecord`.
+ */
+typedef struct {
+  long size;
+  char (*plates)[9];
+  Plate *codes;
+  long *order;
+  char (*dates)[11];
+  char (*times)[6];
+  int *days, *minutes;
+  Record *stays;
+  Memory *m;
+  Record **records;
+} Bench;
+
+/**
+ * @brief Structure to hold a kernel.
+ *
+ * @param name The name of the kernel, in the results.
+ * @param setup Builds the system of the kernel before its rounds, or NULL.
+ * @param prepare Resets the system of the kernel before each round, untimed,
+ * or NULL.
+ * @param run Runs a round, returning a value that depends on all of it.
+ */
+typedef struct {
+  const char *name;
+  void (*setup)(Bench *b);
+  void (*prepare)(Bench *b);
+  long (*run)(Bench *b);
+} Kernel;
+
+/**
+ * @brief Structure to hold the result of a kernel in a previous run.
+ *
+ * @param name The name of the kernel.
+ * @param mean The mean nanoseconds per operation.
+ */
+typedef struct {
+  char name[32];
+  double mean;
+} Baseline;
+
+/**
+ * @brief Structure to hold a gate of the kernel of concurrent entries and
+ * exits.
+ *
+ * @param b A pointer to the inputs.
+ * @param gate The number of the gate, from 0 to BENCH_GATES - 1.
+ * @param visits The number of times each vehicle enters and exits.
+ * @param accepted The number of entries and exits accepted.
+ */
+typedef struct {
+  Bench *b;
+  int gate;
+  int visits;
+  long accepted;
+} Gate;
+
+static unsigned long state; /*State of the generator of the inputs*/
+
+/**
+ * @brief Generates the next pseudo-random number (xorshift64*).
+ *
+ * @return Returns the number.
+ */
+static unsigned long nextRandom(void) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 2685821657736338717UL;
+}
+
+/**
+ * @brief Generates a valid license plate.
+ *
+ * Each pair is letters or digits, with at least one of each.
+ *
+ * @param plate Where the license plate is written, 9 characters.
+ */
+static void randomPlate(char *plate) {
+  int letters = 1 + nextRandom() % 6; /*bit i set if pair i has letters*/
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 2; j++) {
+      plate[i * 3 + j] = letters & (1 << i) ? 'A' + nextRandom() % 26
+                                            : '0' + nextRandom() % 10;
+    }
+    plate[i * 3 + 2] = i < 2 ? '-' : '\0';
+  }
+}
+
+/**
+ * @brief Generates the inputs of the kernels.
+ *
+ * @param b A pointer to the inputs.
+ * @param size The number of operations of each round.
+ * @param seed The seed of the generator.
+ */
+static void generate(Bench *b, long size, unsigned long seed) {
+  state = seed * 2654435761UL + 1;
+  b->size = size;
+  b->plates = malloc(size * sizeof(*b->plates));
+  b->codes = malloc(size * sizeof(Plate));
+  b->order = malloc(size * sizeof(long));
+  b->dates = malloc(size * sizeof(*b->dates));
+  b->times = malloc(size * sizeof(*b->times));
+  b->days = malloc(size * sizeof(int));
+  b->minutes = malloc(size * sizeof(int));
+  b->stays = malloc(size * sizeof(Record));
+  b->records = malloc(size * sizeof(Record *));
+  b->m = NULL;
+  for (long i = 0; i < size; i++) {
+    do {
+      randomPlate(b->plates[i]);
+      b->codes[i] = encodePlate(b->plates[i]);
+    } while (i > 0 && b->codes[i] == b->codes[i - 1]);
+    b->order[i] = i;
+    b->days[i] = BENCH_FIRST_DAY + nextRandom() % (BENCH_DAYS * 100);
+    b->minutes[i] = nextRandom() % MINUTES_PER_DAY;
+    intToDate(b->days[i], b->dates[i]);
+    intToTime(b->minutes[i], b->times[i]);
+    b->stays[i].entry = STAMP(b->days[i], b->minutes[i]);
+    b->stays[i].exit = b->stays[i].entry + nextRandom() % (3 * MINUTES_PER_DAY);
+  }
+  for (long i = size - 1; i > 0; i--) {
+    long j = nextRandom() % (i + 1), t = b->order[i];
+    b->order[i] = b->order[j];
+    b->order[j] = t;
+  }
+}
+
+/**
+ * @brief Replaces the system of the kernels with an empty one.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void freshSystem(Bench *b) {
+  if (b->m) {
+    cleanUp(b->m);
+  }
+  b->m = malloc(sizeof(Memory));
+  initializeSystem(b->m);
+  b->m->output = OUTPUT_NONE;
+}
+
+/**
+ * @brief Adds BENCH_PARKS parks to the system.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void addParks(Bench *b) {
+  char name[16];
+  Park *p;
+  for (int i = 0; i < BENCH_PARKS; i++) {
+    sprintf(name, "park%02d", (i * 7) % BENCH_PARKS);
+    addPark(b->m, name, (int)b->size, 25, 30, 1500, &p);
+  }
+}
+
+/*-------------\
+| KERNELS      |
+\-------------*/
+
+/**
+ * @brief Encodes every license plate.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runEncodePlate(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += encodePlate(b->plates[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief Checks every license plate.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runCheckPlates(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += checkPlates(b->plates[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief Creates an empty system and a record for every license plate.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void prepareAddRecord(Bench *b) {
+  freshSystem(b);
+  hashReserve(b->m->cars, b->size);
+  for (long i = 0; i < b->size; i++) {
+    Record *r = slabAlloc(&b->m->records);
+    r->plate = b->codes[i];
+    r->park = 0;
+    r->flags = 0;
+    r->entry = r->exit = NO_STAMP;
+    b->records[i] = r;
+  }
+}
+
+/**
+ * @brief Adds every record to the hash table.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runAddRecord(Bench *b) {
+  for (long i = 0; i < b->size; i++) {
+    addRecord(b->m, b->records[i]);
+  }
+  return b->m->cars->count;
+}
+
+/**
+ * @brief Adds a record of every license plate to the hash table.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void setupGetListPlates(Bench *b) {
+  prepareAddRecord(b);
+  runAddRecord(b);
+}
+
+/**
+ * @brief Looks every license plate up, in random order.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runGetListPlates(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += getListPlates(b->m->cars, b->codes[b->order[i]])->size;
+  }
+  return sum;
+}
+
+/**
+ * @brief Parses every date.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runDateToInt(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += dateToInt(b->dates[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief Parses every time.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runTimeToInt(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += timeToInt(b->times[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief Formats every date.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runIntToDate(Bench *b) {
+  char date[11];
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    intToDate(b->days[i], date);
+    sum += date[0] + date[9];
+  }
+  return sum;
+}
+
+/**
+ * @brief Formats every time.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runIntToTime(Bench *b) {
+  char time[6];
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    intToTime(b->minutes[i], time);
+    sum += time[0] + time[4];
+  }
+  return sum;
+}
+
+/**
+ * @brief Prices every stay.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runCalculatePrice(Bench *b) {
+  Park park = {.less_60 = 25, .more_60 = 30, .dayly = 1500};
+  long sum = 0;
+  for (long i = 0; i < b->size; i++) {
+    sum += calculatePrice(&park, &b->stays[i]);
+  }
+  return sum;
+}
+
+/**
+ * @brief Fills one park with `size` stays, their exits spread over
+ * BENCH_DAYS days.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void setupCalculateSums(Bench *b) {
+  long perDay = b->size / BENCH_DAYS + 1;
+  Park *p;
+  int spots;
+  freshSystem(b);
+  addParks(b);
+  p = b->m->byName[0];
+  for (long i = 0; i < b->size; i++) {
+    Stamp entry = STAMP(BENCH_FIRST_DAY + i / perDay,
+                        (i % perDay) * (MINUTES_PER_DAY - 1) / perDay);
+    vehicleEnter(b->m, p, b->codes[i], entry, &spots);
+    vehicleExit(b->m, p, b->codes[i], entry, &b->records[i]);
+  }
+}
+
+/**
+ * @brief Computes the daily totals of the park filled by `setupCalculateSums`.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runCalculateSums(Bench *b) {
+  List *sums = calculateSums(b->m->byName[0]);
+  long size = sums->size;
+  freeDateSumList(sums);
+  return size;
+}
+
+/**
+ * @brief Gives `size / BENCH_STAYS` vehicles BENCH_STAYS stays each, in
+ * random parks.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void setupSortRecords(Bench *b) {
+  Stamp now = STAMP(BENCH_FIRST_DAY, 0);
+  Record *r;
+  int spots;
+  freshSystem(b);
+  addParks(b);
+  for (long i = 0; i < b->size / BENCH_STAYS; i++) {
+    for (int j = 0; j < BENCH_STAYS; j++, now++) {
+      Park *p = b->m->parkTable[nextRandom() % BENCH_PARKS];
+      vehicleEnter(b->m, p, b->codes[i], now, &spots);
+      vehicleExit(b->m, p, b->codes[i], now, &r);
+    }
+  }
+}
+
+/**
+ * @brief Sorts the records of every vehicle of `setupSortRecords`.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns a value that depends on every operation.
+ */
+static long runSortRecords(Bench *b) {
+  long sum = 0;
+  for (long i = 0; i < b->size / BENCH_STAYS; i++) {
+    List *l = getListPlates(b->m->cars, b->codes[i]);
+    Node **sorted = sortRecords(b->m, l->head, l->size);
+    sum += sorted[0]->item.record->park;
+    free(sorted);
+  }
+  return sum;
+}
+
+/**
+ * @brief Creates an empty system with BENCH_PARKS parks.
+ *
+ * @param b A pointer to the inputs.
+ */
+static void prepareGates(Bench *b) {
+  freshSystem(b);
+  addParks(b);
+}
+
+/**
+ * @brief Enters and exits the vehicles of a gate, in its own park, once per
+ * visit, each visit at its own minute.
+ *
+ * @param arg A pointer to the Gate.
+ * @return Always returns NULL.
+ */
+static void *runGate(void *arg) {
+  Gate *g = arg;
+  Bench *b = g->b;
+  Park *p = b->m->parkTable[g->gate];
+  Record *r;
+  int spots;
+  for (int visit = 0; visit < g->visits; visit++) {
+    Stamp now = STAMP(BENCH_FIRST_DAY, visit);
+    for (long i = g->gate; i < b->size; i += BENCH_GATES) {
+      g->accepted += vehicleEnter(b->m, p, b->codes[i], now, &spots) == ST_OK;
+      g->accepted += vehicleExit(b->m, p, b->codes[i], now, &r) == ST_OK;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Runs BENCH_GATES gates at once.
+ *
+ * @param b A pointer to the inputs.
+ * @param visits The number of times each vehicle enters and exits.
+ * @return Returns the number of entries and exits accepted.
+ */
+static long runGateThreads(Bench *b, int visits) {
+  pthread_t threads[BENCH_GATES];
+  Gate gates[BENCH_GATES];
+  long accepted = 0;
+  for (int i = 0; i < BENCH_GATES; i++) {
+    gates[i] = (Gate){b, i, visits, 0};
+    pthread_create(&threads[i], NULL, runGate, &gates[i]);
+  }
+  for (int i = 0; i < BENCH_GATES; i++) {
+    pthread_join(threads[i], NULL);
+    accepted += gates[i].accepted;
+  }
+  return accepted;
+}
+
+/**
+ * @brief Enters and exits every vehicle, at BENCH_GATES gates at once.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns the number of entries and exits accepted.
+ */
+static long runGates(Bench *b) { return runGateThreads(b, 1); }
+
+/**
+ * @brief Enters and exits every vehicle twice, at BENCH_GATES gates at once,
+ * so the second exits update vehicles already in the network rankings while
+ * the other gates reorder them.
+ *
+ * @param b A pointer to the inputs.
+ * @return Returns the number of entries and exits accepted.
+ */
+static long runRegates(Bench *b) { return runGateThreads(b, 2); }
+
+/*The kernels, in the order they are run*/
+static const Kernel kernels[] = {
+    {"encodePlate", NULL, NULL, runEncodePlate},
+    {"checkPlates", NULL, NULL, runCheckPlates},
+    {"addRecord", NULL, prepareAddRecord, runAddRecord},
+    {"getListPlates", setupGetListPlates, NULL, runGetListPlates},
+    {"dateToInt", NULL, NULL, runDateToInt},
+    {"timeToInt", NULL, NULL, runTimeToInt},
+    {"intToDate", NULL, NULL, runIntToDate},
+    {"intToTime", NULL, NULL, runIntToTime},
+    {"calculatePrice", NULL, NULL, runCalculatePrice},
+    {"calculateSums", setupCalculateSums, NULL, runCalculateSums},
+    {"sortRecords", setupSortRecords, NULL, runSortRecords},
+    {"gates", NULL, prepareGates, runGates},
+    {"regates", NULL, prepareGates, runRegates},
+};
+
+/*------------\
+| HARNESS     |
+\------------*/
+
+/**
+ * @brief Reads the means of a previous run.
+ *
+ * @param path The CSV file written by the previous run.
+ * @param baselines Where the means are stored.
+ * @return Returns the number of means read, or -1 if the file cannot be read.
+ */
+static int readBaselines(const char *path, Baseline *baselines) {
+  char line[BUF_SIZE];
+  int count = 0;
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return -1;
+  }
+  int capacity = sizeof(kernels) / sizeof(Kernel);
+  while (count < capacity && fgets(line, BUF_SIZE, f)) {
+    if (sscanf(line, "%31[^,],%*d,%*d,%lf", baselines[count].name,
+               &baselines[count].mean) == 2) {
+      count++;
+    }
+  }
+  fclose(f);
+  return count;
+}
+
+/**
+ * @brief Runs the rounds of a kernel and writes its results.
+ *
+ * @param b A pointer to the inputs.
+ * @param k A pointer to the kernel.
+ * @param warmup The number of untimed rounds.
+ * @param rounds The number of timed rounds.
+ * @param baselines The means of a previous run.
+ * @param baselineCount The number of means, or -1 without a previous run.
+ * @return Returns the values returned by the rounds, summed.
+ */
+static long runKernel(Bench *b, const Kernel *k, int warmup, int rounds,
+                      Baseline *baselines, int baselineCount) {
+  double sum = 0, squares = 0, best = 0;
+  long sink = 0;
+  if (k->setup) {
+    k->setup(b);
+  }
+  for (int i = 0; i < warmup + rounds; i++) {
+    struct timespec start, end;
+    double ns;
+    if (k->prepare) {
+      k->prepare(b);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sink += k->run(b);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) /
+         b->size;
+    if (i >= warmup) {
+      sum += ns;
+      squares += ns * ns;
+      best = i == warmup || ns < best ? ns : best;
+    }
+  }
+  double mean = sum / rounds;
+  double variance = rounds > 1 ? (squares - sum * mean) / (rounds - 1) : 0;
+  printf("%s,%ld,%d,%.3f,%.3f,%.3f,%.0f", k->name, b->size, rounds, mean,
+         variance > 0 ? sqrt(variance) : 0, best, 1e9 / mean);
+  if (baselineCount >= 0) {
+    int i = 0;
+    while (i < baselineCount && strcmp(baselines[i].name, k->name) != 0) {
+      i++;
+    }
+    if (i < baselineCount) {
+      printf(",%.3f,%+.1f%%", baselines[i].mean,
+             (mean - baselines[i].mean) / baselines[i].mean * 100);
+    } else {
+      printf(",,");
+    }
+  }
+  printf("\n");
+  fflush(stdout);
+  return sink;
+}
+
+/**
+ * @brief Main function of the benchmarks.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return Returns 0, or 1 if the arguments are not valid.
+ */
+int main(int argc, char *argv[]) {
+  Baseline baselines[sizeof(kernels) / sizeof(Kernel)];
+  const char *filter = "", *baseline = NULL;
+  long size = 100000, sink = 0;
+  int warmup = 2, rounds = 10, baselineCount = -1, valid = 1;
+  unsigned long seed = 1;
+  Bench b;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 == argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+      valid = 0;
+    } else if (argv[i][1] == 'n') {
+      size = atol(argv[++i]);
+    } else if (argv[i][1] == 'r') {
+      rounds = atoi(argv[++i]);
+    } else if (argv[i][1] == 'w') {
+      warmup = atoi(argv[++i]);
+    } else if (argv[i][1] == 's') {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if (argv[i][1] == 'k') {
+      filter = argv[++i];
+    } else if (argv[i][1] == 'b') {
+      baseline = argv[++i];
+    } else {
+      valid = 0;
+    }
+  }
+  if (!valid || size < BENCH_STAYS || size > MAX_EXPECTED || rounds < 1 ||
+      warmup < 0) {
+    fprintf(stderr,
+            "usage: %s [-n <size>] [-r <rounds>] [-w <rounds>] [-s <seed>] "
+            "[-k <name>] [-b <file.csv>]\n",
+            argv[0]);
+    return 1;
+  }
+  if (baseline && (baselineCount = readBaselines(baseline, baselines)) < 0) {
+    perror(baseline);
+    return 1;
+  }
+  generate(&b, size, seed);
+  printf("kernel,size,rounds,ns_per_op,stddev_ns,min_ns,ops_per_s%s\n",
+         baseline ? ",baseline_ns_per_op,change" : "");
+  for (size_t i = 0; i < sizeof(kernels) / sizeof(Kernel); i++) {
+    if (strstr(kernels[i].name, filter)) {
+      sink += runKernel(&b, &kernels[i], warmup, rounds, baselines,
+                        baselineCount);
+    }
+  }
+  fprintf(stderr, "checksum %ld\n", sink);
+  if (b.m) {
+    cleanUp(b.m);
+  }
+  return 0;
+}
@@ -0,0 +1,470 @@
+/**
+ * @file billing.c
+ * @brief Source file for the per-park revenue index.
+ *
+ * This file contains the implementation of the revenue index kept by every
+ * park. Since exits are always recorded in chronological order, the exit days
+ * of a park only grow, so the index is a sorted array of distinct exit days
+ * with the running (prefix) sum of the amounts charged up to each day. It is
+ * updated in constant time when an exit is priced and answers date-range
+ * billing queries with two binary searches. It also contains the network
+ * rollup, which merges the indexes of all the parks by day.
+ *
+ * For the same reason, once the clock of the system passes midnight, the
+ * exits of the days before never change. The billing text of those days is
+ * then rendered once into the Bills of every park, and commands 'f' with no
+ * dates and with one date copy the text of closed days and only format the
+ * rest.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+#define REVENUE_INITIAL_SIZE 16 /*Initial number of days in the index*/
+#define BILLS_INITIAL_SIZE 4096  /*Initial characters of the billing text*/
+#define BILLS_LINE 64            /*Maximum characters of a billing line*/
+
+/**
+ * @brief Creates a new, empty revenue index.
+ *
+ * @return Returns a pointer to the newly created revenue index.
+ */
+Revenue *revenueNew() {
+  Revenue *r = malloc(sizeof(Revenue));
+  r->days = NULL;
+  r->prefix = NULL;
+  r->size = 0;
+  r->capacity = 0;
+  return r;
+}
+
+/**
+ * @brief Adds a charged amount to the revenue index.
+ *
+ * This function adds the amount charged on an exit to the index. If the exit
+ * day is the last day in the index, the amount is added to it, otherwise a new
+ * day is appended with the previous running sum plus the amount. The arrays
+ * grow by doubling, so the operation takes amortized constant time.
+ *
+ * @param r A pointer to the revenue index.
+ * @param day The exit day of the record.
+ * @param paid The amount charged on the exit, in cents.
+ */
+void revenueAdd(Revenue *r, int day, Cents paid) {
+  if (r->size > 0 && r->days[r->size - 1] == day) {
+    r->prefix[r->size - 1] += paid;
+    return;
+  }
+  if (r->size == r->capacity) {
+    r->capacity = r->capacity ? r->capacity * 2 : REVENUE_INITIAL_SIZE;
+    r->days = realloc(r->days, sizeof(int) * r->capacity);
+    r->prefix = realloc(r->prefix, sizeof(Cents) * r->capacity);
+  }
+  r->days[r->size] = day;
+  r->prefix[r->size] = (r->size > 0 ? r->prefix[r->size - 1] : 0) + paid;
+  r->size++;
+}
+
+/**
+ * @brief Finds the number of days in the index up to a given day.
+ *
+ * This function performs a binary search over the sorted exit days and
+ * returns how many of them are less than or equal to the given day.
+ *
+ * @param r A pointer to the revenue index.
+ * @param day The day to search for.
+ * @return Returns the number of days in the index that are <= day.
+ */
+static int revenueCount(Revenue *r, int day) {
+  int low = 0, high = r->size;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (r->days[mid] <= day) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief Calculates the total amount charged between two days.
+ *
+ * This function calculates the total amount charged between two days, both
+ * included, as the difference between two prefix sums.
+ *
+ * @param r A pointer to the revenue index.
+ * @param from The first day of the range.
+ * @param to The last day of the range.
+ * @return Returns the total amount charged in the range, in cents.
+ */
+Cents revenueRange(Revenue *r, int from, int to) {
+  int last = revenueCount(r, to), first = revenueCount(r, from - 1);
+  if (last <= first) {
+    return 0;
+  }
+  return r->prefix[last - 1] - (first > 0 ? r->prefix[first - 1] : 0);
+}
+
+/**
+ * @brief Frees the memory allocated for a revenue index.
+ *
+ * @param r A pointer to the revenue index to be freed.
+ */
+void freeRevenue(Revenue *r) {
+  free(r->days);
+  free(r->prefix);
+  free(r);
+}
+
+/**
+ * @brief Creates new, empty billing text, with no day closed.
+ *
+ * @return Returns a pointer to the newly created billing text.
+ */
+Bills *billsNew() {
+  return calloc(1, sizeof(Bills));
+}
+
+/**
+ * @brief Appends characters to a text, which grows by doubling.
+ *
+ * @param t A pointer to the text.
+ * @param chars The characters to be appended.
+ * @param size The number of characters.
+ */
+static void textAppend(Text *t, const char *chars, int size) {
+  if (t->size + size > t->capacity) {
+    while (t->size + size > t->capacity) {
+      t->capacity = t->capacity ? t->capacity * 2 : BILLS_INITIAL_SIZE;
+    }
+    t->chars = realloc(t->chars, t->capacity);
+  }
+  memcpy(t->chars + t->size, chars, size);
+  t->size += size;
+}
+
+/**
+ * @brief Formats the line of a day of command 'f' with no dates.
+ *
+ * @param line Where the line is written, at least BILLS_LINE characters.
+ * @param day The day.
+ * @param total The total charged on the day, in cents.
+ * @return Returns the number of characters written.
+ */
+static int formatDay(char *line, int day, Cents total) {
+  char date[11];
+  intToDate(day, date);
+  return sprintf(line, "%s " CENTS_FMT "\n", date, CENTS_ARG(total));
+}
+
+/**
+ * @brief Formats the line of an exit of command 'f' with one date.
+ *
+ * @param line Where the line is written, at least BILLS_LINE characters.
+ * @param p A pointer to the park.
+ * @param r A pointer to the record of the exit.
+ * @return Returns the number of characters written.
+ */
+static int formatExit(char *line, Park *p, Record *r) {
+  char time[6], plates[9];
+  intToTime(STAMP_TIME(r->exit), time);
+  decodePlate(r->plate, plates);
+  return sprintf(line, "%s %s " CENTS_FMT "\n", plates, time,
+                 CENTS_ARG(calculatePrice(p, r)));
+}
+
+/**
+ * @brief Renders the billing text of the days of a park before a given day.
+ *
+ * This function is called for every park when the clock passes midnight, see
+ * `billsClose`, so a day is closed as soon as no exit can fall on it. The
+ * caller holds the lock of the park. The records of the park are in exit
+ * order, so the records not yet rendered are the ones after `last`, and those
+ * of each day are rendered together. The days come from the revenue index, so
+ * a day is closed even if every record of it was dropped by its vehicle, and
+ * the lines of the records dropped are left out, see `retainRecords`.
+ *
+ * @param p A pointer to the park.
+ * @param day The first day that is not closed.
+ */
+void billsFreeze(Park *p, int day) {
+  Bills *b = p->bills;
+  Revenue *r = p->revenue;
+  Node *n = b->last ? b->last->next : p->records->head;
+  char line[BILLS_LINE];
+  long span;
+  if (day <= b->until) {
+    return;
+  }
+  span = traceBegin();
+  for (; b->days < r->size && r->days[b->days] < day; b->days++) {
+    int exit = r->days[b->days];
+    Cents total = r->prefix[b->days] - (b->days ? r->prefix[b->days - 1] : 0);
+    textAppend(&b->totals, line, formatDay(line, exit, total));
+    if (b->days + 2 > b->capacity) {
+      b->capacity = b->capacity ? b->capacity * 2 : REVENUE_INITIAL_SIZE;
+      b->offsets = realloc(b->offsets, sizeof(long) * b->capacity);
+    }
+    b->offsets[b->days] = b->exits.size;
+    for (; n && STAMP_DAY(n->item.record->exit) == exit; n = n->next) {
+      if (!(__atomic_load_n(&n->item.record->flags, __ATOMIC_ACQUIRE) &
+            RECORD_EVICTED)) {
+        textAppend(&b->exits, line, formatExit(line, p, n->item.record));
+      }
+      b->last = n;
+    }
+  }
+  if (b->days > 0) {
+    b->offsets[b->days] = b->exits.size;
+  }
+  __atomic_store_n(&b->until, day, __ATOMIC_RELEASE);
+  traceEnd("billsFreeze", span);
+}
+
+/**
+ * @brief Closes the days before the current one in every park, once the
+ * clock of the system has passed midnight since they were last closed.
+ *
+ * The day is claimed with a compare and swap, so only one gate renders it,
+ * and each park is frozen under its own lock, taken alone. The caller holds
+ * the lock of the hash table, so no park is added or removed meanwhile, and
+ * no lock of a park.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+void billsClose(Memory *m) {
+  int day = STAMP_DAY(atomic_load(&m->now));
+  int closed = atomic_load(&m->closed);
+  do {
+    if (day <= closed) {
+      return;
+    }
+  } while (!atomic_compare_exchange_weak(&m->closed, &closed, day));
+  for (int i = 0; i < MAX_PARKS; i++) {
+    Park *p = m->parkTable[i];
+    if (p) {
+      pthread_mutex_lock(&p->lock);
+      billsFreeze(p, day);
+      pthread_mutex_unlock(&p->lock);
+    }
+  }
+}
+
+/**
+ * @brief Renders again the billing text of the exits of the closed days of a
+ * park, after the records dropped by their vehicles were removed from it.
+ *
+ * Only the lines of the records still kept are rendered, so the text takes
+ * no more room than they do, and its spare room is given back. The lines of
+ * the totals of the days do not change. The caller holds the lock of the
+ * park, see `compactRecords`.
+ *
+ * @param p A pointer to the park.
+ */
+void billsRebuild(Park *p) {
+  Bills *b = p->bills;
+  Revenue *r = p->revenue;
+  char line[BILLS_LINE];
+  int i = 0, exit;
+  b->exits.size = 0;
+  for (Node *n = p->records->head;
+       n && (exit = STAMP_DAY(n->item.record->exit)) < b->until; n = n->next) {
+    while (i < b->days && r->days[i] <= exit) {
+      b->offsets[i++] = b->exits.size;
+    }
+    if (!(__atomic_load_n(&n->item.record->flags, __ATOMIC_ACQUIRE) &
+          RECORD_EVICTED)) {
+      textAppend(&b->exits, line, formatExit(line, p, n->item.record));
+    }
+  }
+  while (i <= b->days && b->days > 0) {
+    b->offsets[i++] = b->exits.size;
+  }
+  if (b->exits.capacity > BILLS_INITIAL_SIZE &&
+      b->exits.capacity > 2 * b->exits.size) {
+    b->exits.capacity = b->exits.size > BILLS_INITIAL_SIZE
+                            ? b->exits.size
+                            : BILLS_INITIAL_SIZE;
+    b->exits.chars = realloc(b->exits.chars, b->exits.capacity);
+  }
+}
+
+/**
+ * @brief Prints the total charged by a park on each day, as command 'f' with
+ * no dates.
+ *
+ * The lines of the closed days are copied, and the other days are formatted
+ * from the revenue index.
+ *
+ * @param p A pointer to the park.
+ * @param out The stream to print to.
+ */
+void billsPrint(Park *p, FILE *out) {
+  Bills *b = p->bills;
+  Revenue *r = p->revenue;
+  char line[BILLS_LINE];
+  if (b->totals.size > 0) {
+    fwrite(b->totals.chars, 1, b->totals.size, out);
+  }
+  for (int i = b->days; i < r->size; i++) {
+    formatDay(line, r->days[i], r->prefix[i] - (i > 0 ? r->prefix[i - 1] : 0));
+    fputs(line, out);
+  }
+}
+
+/**
+ * @brief Prints the exits from a park on a day, as command 'f' with one date.
+ *
+ * The lines of a closed day are copied, found by a binary search over the
+ * closed days. On other days, only the records after the last one
+ * rendered are read. While the park has records dropped by their vehicles
+ * and not yet removed, see `billsRebuild`, the lines of a closed day are
+ * formatted from the records still kept instead, so the exits listed are
+ * always those of `parkBillsDate`.
+ *
+ * @param p A pointer to the park.
+ * @param day The day.
+ * @param out The stream to print to.
+ */
+void billsPrintDate(Park *p, int day, FILE *out) {
+  Bills *b = p->bills;
+  Node *n = b->last ? b->last->next : p->records->head;
+  char line[BILLS_LINE];
+  if (day < b->until && __atomic_load_n(&p->evicted, __ATOMIC_ACQUIRE) > 0) {
+    n = p->records->head;
+  } else if (day < b->until) {
+    int low = 0, high = b->days;
+    while (low < high) {
+      int mid = low + (high - low) / 2;
+      if (p->revenue->days[mid] < day) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (low < b->days && p->revenue->days[low] == day) {
+      fwrite(b->exits.chars + b->offsets[low], 1,
+             b->offsets[low + 1] - b->offsets[low], out);
+    }
+    return;
+  }
+  for (; n; n = n->next) {
+    Record *r = n->item.record;
+    if (STAMP_DAY(r->exit) == day &&
+        !(__atomic_load_n(&r->flags, __ATOMIC_ACQUIRE) & RECORD_EVICTED)) {
+      formatExit(line, p, r);
+      fputs(line, out);
+    }
+  }
+}
+
+/**
+ * @brief Frees the memory allocated for the billing text of a park.
+ *
+ * @param b A pointer to the billing text to be freed.
+ */
+void freeBills(Bills *b) {
+  free(b->totals.chars);
+  free(b->exits.chars);
+  free(b->offsets);
+  free(b);
+}
+
+/**
+ * @brief Structure to hold the position of the merge in the revenue index of
+ * a park.
+ *
+ * @param r A pointer to the revenue index.
+ * @param i The index of the next day to be merged.
+ */
+typedef struct {
+  Revenue *r;
+  int i;
+} DayCursor;
+
+/**
+ * @brief Moves a cursor down the heap of the merge until the days of its
+ * children are not earlier than its own.
+ *
+ * @param heap The cursors, the one at the earliest day at the root.
+ * @param size The number of cursors.
+ * @param i The index of the cursor.
+ */
+static void cursorSift(DayCursor *heap, int size, int i) {
+  DayCursor c = heap[i];
+  int day = c.r->days[c.i];
+  while (2 * i + 1 < size) {
+    int child = 2 * i + 1;
+    if (child + 1 < size && heap[child + 1].r->days[heap[child + 1].i] <
+                                heap[child].r->days[heap[child].i]) {
+      child++;
+    }
+    if (heap[child].r->days[heap[child].i] >= day) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = c;
+}
+
+/**
+ * @brief Calculates the total amount charged each day across all parks.
+ *
+ * The revenue indexes of the parks are sorted by day, so they are merged
+ * with a min-heap of cursors, one per park with days, keyed by the next day
+ * of each: every day is taken from the root, after which its cursor moves on
+ * and is sifted down, in O(D log P) for D days of P parks.
+ *
+ * @param parks A pointer to the list of parks.
+ * @param subtotals An array, with one entry per park in list order, where the
+ * total charged by each park is stored.
+ * @return Returns a pointer to the list of date sum items, in day order.
+ */
+List *calculateNetworkSums(List *parks, Cents *subtotals) {
+  List *dates = ListNew();
+  DayCursor *heap = malloc(sizeof(DayCursor) * (parks->size + 1));
+  int size = 0, i = 0;
+  for (Node *n = parks->head; n; n = n->next, i++) {
+    Revenue *r = n->item.park->revenue;
+    subtotals[i] = r->size > 0 ? r->prefix[r->size - 1] : 0;
+    if (r->size > 0) {
+      heap[size++] = (DayCursor){r, 0};
+    }
+  }
+  for (i = size / 2 - 1; i >= 0; i--) {
+    cursorSift(heap, size, i);
+  }
+  while (size > 0) {
+    DateSum total = {heap[0].r->days[heap[0].i], 0};
+    while (size > 0 && heap[0].r->days[heap[0].i] == total.exitDay) {
+      Revenue *r = heap[0].r;
+      int j = heap[0].i++;
+      total.charged += r->prefix[j] - (j > 0 ? r->prefix[j - 1] : 0);
+      if (heap[0].i == r->size) {
+        heap[0] = heap[--size];
+      }
+      if (size > 0) {
+        cursorSift(heap, size, 0);
+      }
+    }
+    Node *n = malloc(sizeof(Node));
+    n->item.dateSum = malloc(sizeof(DateSum));
+    *n->item.dateSum = total;
+    n->next = NULL;
+    if (dates->size == 0) {
+      dates->head = n;
+    } else {
+      dates->tail->next = n;
+    }
+    dates->tail = n;
+    dates->size++;
+  }
+  free(heap);
+  return dates;
+}
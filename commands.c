@@ -1,3 +1,4 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,29 +7,66 @@
 
 // TODO - CRIAR ABSTRAÇÃO READBUFFER (passar tuple de ponteiros)
 
-static int readBuffer(char *buffer, char *name, int *d1) {
-  char date[11];
+/**
+ * @brief Reads a park name and up to two dates from the arguments of 'f'.
+ *
+ * The name may be quoted, to have spaces. Each date read is checked with
+ * `checkDateFormat`, and stored as -1 if it is not valid.
+ *
+ * @param buffer The arguments.
+ * @param name Where the name is stored.
+ * @param d1 Where the first date is stored, if it is read.
+ * @param d2 Where the second date is stored, if it is read.
+ * @return Returns the number of items read: 1 for the name alone, 2 with the
+ * first date and 3 with both, or 0 if nothing was read.
+ */
+static int readBuffer(char *buffer, char *name, int *d1, int *d2) {
+  char date[11], date2[11];
   int result;
   if (strchr(buffer, '\"')) {
-    result = sscanf(buffer, " \"%[^\"]\" %s", name, date);
+    result = sscanf(buffer, " \"%[^\"]\" %10s %10s", name, date, date2);
   } else {
-    result = sscanf(buffer, "%s %s", name, date);
+    result = sscanf(buffer, "%s %10s %10s", name, date, date2);
   }
   if (result > 1) {
-    *d1 = dateToInt(date);
+    *d1 = checkDateFormat(date) ? dateToInt(date) : -1;
+  }
+  if (result > 2) {
+    *d2 = checkDateFormat(date2) ? dateToInt(date2) : -1;
   }
   return result;
 }
 
 /**
- * @brief Processes command 'f', retrieves all billings from a park or billings
- * from a specific date.
+ * @brief Prints the total billed by a park between two dates.
  *
- * The function reads the park name and date from
- * the buffer. If only the park name is read, it prints all billings for that
- * park. If both the park name and date are read, it prints the billings for
- * that park on that date. If the park is not found, it prints an error
- * message. If the date is in the past, it prints an error message.
+ * The total is read from the revenue index of the park, so the cost is
+ * logarithmic in the number of days with exits.
+ *
+ * @param p A pointer to the park.
+ * @param from The first day of the range.
+ * @param to The last day of the range.
+ * @param out The stream to print to.
+ */
+static void printBillsRange(Park *p, int from, int to, FILE *out) {
+  char date[11], date2[11];
+  intToDate(from, date);
+  intToDate(to, date2);
+  fprintf(out, "%s %s " CENTS_FMT "\n", date, date2,
+         CENTS_ARG(revenueRange(p->revenue, from, to)));
+}
+
+/**
+ * @brief Processes command 'f', retrieves all billings from a park, billings
+ * from a specific date or the total billed between two dates.
+ *
+ * The function reads the park name and up to two dates from the buffer. If
+ * only the park name is read, it prints all billings for that park. If the
+ * park name and one date are read, it prints the billings for that park on
+ * that date. If two dates are read, it prints the total billed by the park in
+ * that range of dates, both included. If the park is not found, it prints an
+ * error message. If a date is not valid or in the future, or the range is
+ * reversed, it prints an error message.
  *
  * @param m Pointer to the Memory structure, which contains the list of parks
  * and records.
@@ -37,23 +75,208 @@ static int readBuffer(char *buffer, char *name, int *d1) {
  */
 void processCommand_f(Memory *m, char *buffer) {
   char nome[BUF_SIZE];
-  int date, checkValue;
-  checkValue = readBuffer(buffer, nome, &date);
-  Park *p1 = listGetPark(m->parks, nome);
+  int date, date2, checkValue;
+  checkValue = readBuffer(buffer, nome, &date, &date2);
+  Park *p1 = getPark(m, nome);
   if (checkValue == 1) {
     if (!p1) {
-      printf(ERR_PARK_NOT_FOUND(nome));
-    } else {
-      printBills(p1->records);
+      reject(m, ERR_PARK_NOT_FOUND(nome));
+    } else if (m->output == OUTPUT_ALL) {
+      printBills(m, p1->id);
     }
-  } else if (checkValue > 1) {
+  } else if (checkValue == 2) {
     if (!p1) {
-      printf(ERR_PARK_NOT_FOUND(nome));
-    } else if (m->date - date < 0) {
-      printf(ERR_INVALID_DATE);
-    } else {
-      printBillsDate(p1->records, date);
+      reject(m, ERR_PARK_NOT_FOUND(nome));
+    } else if (date < 0 || STAMP_DAY(m->now) < date) {
+      reject(m, ERR_INVALID_DATE);
+    } else if (m->output == OUTPUT_ALL) {
+      printBillsDate(m, p1->id, date);
+    }
+  } else if (checkValue > 2) {
+    if (!p1) {
+      reject(m, ERR_PARK_NOT_FOUND(nome));
+    } else if (date < 0 || date2 < 0 || STAMP_DAY(m->now) < date ||
+               date2 < date) {
+      reject(m, ERR_INVALID_DATE);
+    } else if (m->output == OUTPUT_ALL) {
+      printBillsRange(p1, date, date2, m->out);
+    }
+  }
+}
+
+/**
+ * @brief Processes command 'n', retrieves the billings of the whole network.
+ *
+ * The function prints the total billed each day across all parks, followed by
+ * the total billed by each park. The command takes no arguments.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks.
+ * @param buffer Buffer containing the command arguments (unused).
+ * @return void
+ */
+void processCommand_n(Memory *m, char *buffer) {
+  (void)buffer;
+  if (m->output == OUTPUT_ALL) {
+    printNetworkBills(m->parks, m->out);
+  }
+}
+
+/**
+ * @brief Processes command 't', lists the vehicles that paid the most or
+ * visited the most, in the whole network or in a park.
+ *
+ * The function reads the ranking ("spend" or "visits"), the number of
+ * vehicles to list and, optionally, a park name from the buffer. The vehicles
+ * are read from the maintained rankings, so the hash table is not walked. If
+ * the ranking or the number of vehicles is not valid, or the park is not
+ * found, it prints an error message.
+ *
+ * @param m Pointer to the Memory structure, which contains the rankings.
+ * @param buffer Buffer containing the command arguments.
+ * @return void
+ */
+void processCommand_t(Memory *m, char *buffer) {
+  char ranking[BUF_SIZE], nome[BUF_SIZE];
+  int k = 0, offset = 0, kind;
+  TopK *top = m->top;
+  sscanf(buffer, "%s %d%n", ranking, &k, &offset);
+  if (strchr(buffer + offset, '\"')) {
+    sscanf(buffer + offset, " \"%[^\"]\"", nome);
+  } else if (sscanf(buffer + offset, "%s", nome) != 1) {
+    nome[0] = '\0';
+  }
+  kind = strcmp(ranking, "spend") == 0 ? RANK_SPEND : RANK_VISITS;
+  if (strcmp(ranking, "spend") != 0 && strcmp(ranking, "visits") != 0) {
+    reject(m, ERR_INVALID_RANKING(ranking));
+  } else if (k <= 0 || k > TOP_K) {
+    reject(m, ERR_INVALID_TOP_SIZE(k));
+  } else if (nome[0] && !getPark(m, nome)) {
+    reject(m, ERR_PARK_NOT_FOUND(nome));
+  } else if (m->output == OUTPUT_ALL) {
+    if (nome[0]) {
+      top = getPark(m, nome)->top;
     }
+    printTop(&top[kind], k, m->out);
+  }
+}
+
+/**
+ * @brief Processes command 'o', retrieves the occupancy of a park at a past
+ * moment or its peak occupancy between two dates.
+ *
+ * The function reads the park name and two more arguments from the buffer. If
+ * the second one is a time, it prints the occupancy of the park at the end of
+ * that minute. If it is a date, it prints the peak occupancy of the park
+ * between the two dates, both included. If the park is not found, it prints
+ * an error message. If an argument is missing, a date or time is not valid or
+ * is in the future, or the range is reversed, it prints an error message.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks.
+ * @param buffer Buffer containing the command arguments.
+ * @return void
+ */
+void processCommand_o(Memory *m, char *buffer) {
+  char nome[BUF_SIZE] = "", data[11] = "", arg[11] = "", data2[11];
+  int date, time, read;
+  if (strchr(buffer, '\"')) {
+    read = sscanf(buffer, " \"%[^\"]\" %10s %10s", nome, data, arg);
+  } else {
+    read = sscanf(buffer, "%s %10s %10s", nome, data, arg);
+  }
+  Park *p1 = getPark(m, nome);
+  if (!p1) {
+    reject(m, ERR_PARK_NOT_FOUND(nome));
+    return;
+  } else if (read != 3) {
+    reject(m, ERR_INVALID_DATE);
+    return;
+  }
+  date = dateToInt(data);
+  if (strchr(arg, ':')) {
+    time = timeToInt(arg);
+    if (!checkDateFormat(data) || !checkTimeFormat(arg) ||
+        STAMP(date, time) > m->now) {
+      reject(m, ERR_INVALID_DATE);
+    } else if (m->output == OUTPUT_ALL) {
+      intToDate(date, data);
+      intToTime(time, arg);
+      fprintf(m->out, "%s %s %d\n", data, arg,
+              historyAt(p1->history, STAMP(date, time)));
+    }
+  } else {
+    int date2 = dateToInt(arg);
+    if (!checkDateFormat(data) || !checkDateFormat(arg) ||
+        date > STAMP_DAY(m->now) || date2 < date) {
+      reject(m, ERR_INVALID_DATE);
+    } else if (m->output == OUTPUT_ALL) {
+      intToDate(date, data);
+      intToDate(date2, data2);
+      fprintf(m->out, "%s %s %d\n", data, data2,
+              historyPeak(p1->history, date, date2));
+    }
+  }
+}
+
+/**
+ * @brief Processes command 'u', retrieves the statistics of the parks.
+ *
+ * With no arguments, the function prints one line per park, in the order they
+ * were added, with its entries and exits, the mean, median, 90th and 99th
+ * percentile of its stays and its exits per spot, each one read from the
+ * statistics kept by the park, so the cost does not grow with its history.
+ * Given a park name, it prints the entries, exits and peak occupancy of that
+ * park on each day with entries or exits. If the park is not found, it
+ * prints an error message.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks.
+ * @param buffer Buffer containing the command arguments.
+ * @return void
+ */
+void processCommand_u(Memory *m, char *buffer) {
+  char nome[BUF_SIZE] = "";
+  Park *p1;
+  if (strchr(buffer, '\"')) {
+    sscanf(buffer, " \"%[^\"]\"", nome);
+  } else {
+    sscanf(buffer, "%s", nome);
+  }
+  if (!nome[0]) {
+    for (Node *n = m->parks->head; n && m->output == OUTPUT_ALL; n = n->next) {
+      statsPrint(n->item.park, m->out);
+    }
+  } else if (!(p1 = getPark(m, nome))) {
+    reject(m, ERR_PARK_NOT_FOUND(nome));
+  } else if (m->output == OUTPUT_ALL) {
+    statsPrintDays(p1, m->out);
+  }
+}
+
+/**
+ * @brief Processes command 'l', lists the vehicles that overstay in a park.
+ *
+ * The function reads the park name from the buffer and prints the plate and
+ * the entry of each vehicle inside the park for longer than the minutes of
+ * option -l, in the order they overstayed, from the list kept by the timer
+ * wheel, so the vehicles that do not overstay are never looked at. Without
+ * the option, no vehicle overstays. If the park is not found, it prints an
+ * error message.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks.
+ * @param buffer Buffer containing the command arguments.
+ * @return void
+ */
+void processCommand_l(Memory *m, char *buffer) {
+  char nome[BUF_SIZE] = "";
+  Park *p1;
+  if (strchr(buffer, '\"')) {
+    sscanf(buffer, " \"%[^\"]\"", nome);
+  } else {
+    sscanf(buffer, "%s", nome);
+  }
+  if (!(p1 = getPark(m, nome))) {
+    reject(m, ERR_PARK_NOT_FOUND(nome));
+  } else if (m->output == OUTPUT_ALL && m->wheel) {
+    wheelPrint(m, p1);
   }
 }
 
@@ -77,13 +300,15 @@ void processCommand_r(Memory *m, char *buffer) {
   } else {
     sscanf(buffer, "%s", nome);
   }
-  Park *p1 = listGetPark(m->parks, nome);
+  Park *p1 = getPark(m, nome);
   if (!p1) {
     // checking if park exists
-    printf(ERR_PARK_NOT_FOUND(nome));
+    reject(m, ERR_PARK_NOT_FOUND(nome));
   } else {
     removePark(m, p1->id);
-    printRemainingParks(m->parks);
+    if (m->output == OUTPUT_ALL) {
+      printRemainingParks(m);
+    }
   }
 }
 
@@ -94,7 +319,10 @@ void processCommand_r(Memory *m, char *buffer) {
  * If the buffer is not empty, the function reads the license plates from the
  * buffer. If the license plates are not valid, it prints an error message.
  * If the license plates are valid, it prints all records with that license
- * plate. If no records are found, it prints an error message.
+ * plate. If no records are found, it prints an error message. Given one date,
+ * only the stays on or after that day are printed, and given two, only the
+ * stays with a day between them, both included. If a date is not valid or
+ * the range is reversed, it prints an error message.
  *
  * @param m Pointer to the Memory structure, which contains the list of
  * records.
@@ -102,13 +330,120 @@ void processCommand_r(Memory *m, char *buffer) {
  * @return void
  */
 void processCommand_v(Memory *m, char *buffer) {
-  char plates[9];
-  sscanf(buffer, "%s", plates);
+  char plates[BUF_SIZE], date[BUF_SIZE], date2[BUF_SIZE];
+  int read = sscanf(buffer, "%s %s %s", plates, date, date2);
+  int valid = 1, from = 0, to = INT_MAX;
+  if (read > 1 && (valid = checkDateFormat(date))) {
+    from = dateToInt(date);
+  }
+  if (valid && read > 2 && (valid = checkDateFormat(date2))) {
+    to = dateToInt(date2);
+  }
   if (!checkPlates(plates)) {
-    printf(ERR_INVALID_LICENSE(plates));
-  } else if (!printRecords(m, plates)) {
-    printf(ERR_NO_ENTRYS_FOUND(plates));
+    reject(m, ERR_INVALID_LICENSE(plates));
+  } else if (!getListPlates(m->cars, encodePlate(plates))) {
+    reject(m, ERR_NO_ENTRYS_FOUND(plates));
+  } else if (!valid || to < from) {
+    reject(m, ERR_INVALID_DATE);
+  } else if (m->output == OUTPUT_ALL) {
+    printRecords(m, encodePlate(plates), from, to);
+  }
+}
+
+/**
+ * @brief Prints the error message of a failed entry or exit.
+ *
+ * @param m Pointer to the Memory structure.
+ * @param status The status returned by `vehicleEnter` or `vehicleExit`.
+ * @param name The name of the park, as given in the command.
+ * @param plates The license plate, as given in the command.
+ */
+static void rejectStatus(Memory *m, int status, char *name, char *plates) {
+  switch (status) {
+    case ST_PARK_NOT_FOUND:
+      reject(m, ERR_PARK_NOT_FOUND(name));
+      break;
+    case ST_FULL_PARK:
+      reject(m, ERR_FULL_PARK(name));
+      break;
+    case ST_INVALID_LICENSE:
+      reject(m, ERR_INVALID_LICENSE(plates));
+      break;
+    case ST_INVALID_ENTRY:
+      reject(m, ERR_INVALID_ENTRY(plates));
+      break;
+    case ST_INVALID_EXIT:
+      reject(m, ERR_INVALID_EXIT(plates));
+      break;
+    case ST_INVALID_DATE:
+      reject(m, ERR_INVALID_DATE);
+      break;
+  }
+}
+
+/**
+ * @brief Removes a vehicle from a park.
+ *
+ * This is the exit of command 's', shared by the text and binary formats. If
+ * the exit is valid, the record is closed, the occupancy history, the
+ * statistics, the clock, the revenue index and the rankings are updated, the
+ * list of the park drops the records its vehicles dropped once they are half
+ * of it, the timer of the stay is cancelled, the exit is published to the
+ * event ring, and nothing is printed. If the clock passed midnight, the days
+ * before are then closed in every park, see `billsClose`. It may run at many
+ * gates at once, like `vehicleEnter`.
+ *
+ * @param m Pointer to the Memory structure.
+ * @param p1 Pointer to the park, or NULL if it was not found.
+ * @param plate The encoded license plate of the vehicle.
+ * @param now The date and time of the exit.
+ * @param exited Pointer to where the closed record is stored.
+ * @return Returns ST_OK, or the status of the first validation that failed.
+ */
+int vehicleExit(Memory *m, Park *p1, Plate plate, Stamp now, Record **exited) {
+  long span;
+  int status;
+  lockTable(m);
+  lockVehicle(m, plate);
+  if (p1) {
+    pthread_mutex_lock(&p1->lock);
+  }
+  span = traceBegin();
+  status = checkExit(m, p1, plate, now);
+  traceEnd("checkExit", span);
+  if (status == ST_OK && !updateMemoryTime(m, now)) {
+    status = ST_INVALID_DATE;  // another gate moved the clock past it
+  }
+  if (status == ST_OK) {
+    Record *r1 = getLastRecord(m->cars, plate);
+    Cents paid;
+    r1->exit = now;
+    p1->occupancy--;
+    historyAdd(p1->history, now, p1->occupancy);
+    statsExit(p1->stats, r1, p1->occupancy);
+    paid = calculatePrice(p1, r1);
+    listAddRecord(&m->nodes, p1->records, r1);
+    if (__atomic_load_n(&p1->evicted, __ATOMIC_RELAXED) * 2 >
+        p1->records->size) {
+      compactRecords(m, p1);
+    }
+    revenueAdd(p1->revenue, STAMP_DAY(now), paid);
+    rankExit(m, p1, r1, paid);
+    if (m->wheel) {
+      wheelCancel(m, getHashNode(m->cars, plate));
+    }
+    eventsPublish(m, CM_EXIT_VEHICLE, p1, plate, now, r1->entry, paid);
+    *exited = r1;
   }
+  if (p1) {
+    pthread_mutex_unlock(&p1->lock);
+  }
+  if (status == ST_OK) {
+    billsClose(m);
+  }
+  unlockVehicle(m, plate);
+  unlockTable(m);
+  return status;
 }
 
 /**
@@ -128,28 +463,83 @@ void processCommand_v(Memory *m, char *buffer) {
  */
 void processCommand_s(Memory *m, char *buffer) {
   char nome[BUF_SIZE], plates[9], data[11], hora[6];
-  int time, date;
+  Record *r1;
+  int status;
   if (strchr(buffer, '\"')) {
     sscanf(buffer, " \"%[^\"]\" %s %s %s", nome, plates, data, hora);
   } else {
     sscanf(buffer, "%s %s %s %s", nome, plates, data, hora);
   }
-  Park *p1 = listGetPark(m->parks, nome);
-  Record *r1 = getLastRecord(m->cars, plates);
-  date = dateToInt(data);
-  time = timeToInt(hora);
-  if (validationsS(m, p1, r1, nome, plates, data, hora)) {
-    // everything is valid, adding vehicle to the list
-    r1->exitDay = date;
-    r1->exitHour = time;
-    r1->park->occupancy--;
-    updateMemoryTime(m, date, time);
-    calculatePrice(r1);
-    printSaida(r1);
-    listAddRecord(r1->park->records, r1);
+  status = vehicleExit(m, getPark(m, nome), encodePlate(plates),
+                       parseStamp(data, hora), &r1);
+  if (status != ST_OK) {
+    rejectStatus(m, status, nome, plates);
+  } else if (m->output == OUTPUT_ALL) {
+    printSaida(m->parkTable[r1->park], r1, m->out);
   }
 }
 
+/**
+ * @brief Enters a vehicle in a park.
+ *
+ * This is the entry of command 'e', shared by the text and binary formats. If
+ * the entry is valid, a new record is added, the occupancy history, the
+ * statistics and the clock are updated, the entry is published to the event
+ * ring, the timer of the stay is armed if overstays are detected, and nothing
+ * is printed. If the clock passed midnight, the days before are then closed
+ * in every park, see `billsClose`, after the lock of the park is released.
+ * Entries and exits may be called by many threads at once: they hold the
+ * table lock shared and the locks of the vehicle and of the park.
+ *
+ * @param m Pointer to the Memory structure.
+ * @param p1 Pointer to the park, or NULL if it was not found.
+ * @param plate The encoded license plate of the vehicle.
+ * @param now The date and time of the entry.
+ * @param spots Pointer to where the free spots left in the park are stored.
+ * @return Returns ST_OK, or the status of the first validation that failed.
+ */
+int vehicleEnter(Memory *m, Park *p1, Plate plate, Stamp now, int *spots) {
+  long span;
+  int status;
+  lockTable(m);
+  lockVehicle(m, plate);
+  if (p1) {
+    pthread_mutex_lock(&p1->lock);
+  }
+  span = traceBegin();
+  status = checkEntry(m, p1, plate, now);
+  traceEnd("checkEntry", span);
+  if (status == ST_OK && !updateMemoryTime(m, now)) {
+    status = ST_INVALID_DATE;  // another gate moved the clock past it
+  }
+  if (status == ST_OK) {
+    Record *newR = slabAlloc(&m->records);
+    newR->plate = plate;
+    newR->park = p1->index;
+    newR->flags = 0;
+    newR->entry = now;
+    newR->exit = NO_STAMP;
+    p1->occupancy++;
+    historyAdd(p1->history, now, p1->occupancy);
+    statsEnter(p1->stats, now, p1->occupancy);
+    addRecord(m, newR);
+    *spots = p1->capacity - p1->occupancy;
+    eventsPublish(m, CM_ADD_VEHICLE, p1, plate, now, *spots, 0);
+    if (m->wheel) {
+      wheelArm(m, getHashNode(m->cars, plate), newR);
+    }
+  }
+  if (p1) {
+    pthread_mutex_unlock(&p1->lock);
+  }
+  if (status == ST_OK) {
+    billsClose(m);
+  }
+  unlockVehicle(m, plate);
+  unlockTable(m);
+  return status;
+}
+
 /**
  * @brief Processes command 'e', checks if inputs are valid and inserts the
  * vehicle in the park.
@@ -168,29 +558,84 @@ void processCommand_s(Memory *m, char *buffer) {
  */
 void processCommand_e(Memory *m, char *buffer) {
   char nome[BUF_SIZE], plates[20], data[11], hora[6];
-  int time, date;
+  Park *p1;
+  int status, spots;
   if (strchr(buffer, '\"')) {
     sscanf(buffer, " \"%[^\"]\" %s %s %s", nome, plates, data, hora);
   } else {
     sscanf(buffer, "%s %s %s %s", nome, plates, data, hora);
   }
-  Park *p1 = listGetPark(m->parks, nome);
-  Record *r1 = getLastRecord(m->cars, plates);
-  date = dateToInt(data);
-  time = timeToInt(hora);
-  if (validationsE(m, p1, r1, nome, plates, data, hora)) {
-    Record *newR = malloc(sizeof(Record));
-    newR->park = p1;
-    newR->entryDay = date;
-    newR->entryHour = time;
-    newR->exitDay = NO_DATE;
-    newR->exitHour = NO_TIME;
-    newR->park->occupancy++;
-    updateMemoryTime(m, date, time);
-    strcpy(newR->plates, plates);
-    addRecord(m->cars, newR);
-    printf("%s %d\n", nome, p1->capacity - p1->occupancy);
+  p1 = getPark(m, nome);
+  status = vehicleEnter(m, p1, encodePlate(plates), parseStamp(data, hora),
+                        &spots);
+  if (status != ST_OK) {
+    rejectStatus(m, status, nome, plates);
+  } else if (m->output == OUTPUT_ALL) {
+    fprintf(m->out, "%s %d\n", nome, spots);
+  }
+}
+
+/**
+ * @brief Adds a new park.
+ *
+ * This is the creation of a park by command 'p', shared by the text format
+ * and the library. If the park is valid, it is given the next id and the
+ * first free slot of the park table, it is published to the event ring, and
+ * nothing is printed.
+ *
+ * @param m Pointer to the Memory structure.
+ * @param name The name of the park.
+ * @param capacity The number of spots of the park.
+ * @param first The price of each 15 minutes in the first hour.
+ * @param next The price of each 15 minutes after the first hour.
+ * @param daily The largest price of each 24 hours.
+ * @param added Pointer to where the new park is stored.
+ * @return Returns ST_OK, or the status of the first validation that failed.
+ */
+int addPark(Memory *m, char *name, int capacity, Cents first, Cents next,
+            Cents daily, Park **added) {
+  Park *p1 = aligned_alloc(CACHE_LINE, sizeof(Park));
+  long span;
+  int status;
+  p1->name = name;
+  p1->capacity = capacity;
+  p1->less_60 = first;
+  p1->more_60 = next;
+  p1->dayly = daily;
+  p1->records = NULL;
+  p1->revenue = NULL;
+  p1->bills = NULL;
+  p1->history = NULL;
+  p1->stats = NULL;
+  span = traceBegin();
+  status = checkPark(m, p1);
+  traceEnd("checkPark", span);
+  if (status != ST_OK) {
+    free(p1);
+    return status;
+  }
+  // everything is valid, adding park to the list
+  p1->occupancy = 0;
+  p1->evicted = 0;
+  pthread_mutex_init(&p1->lock, NULL);
+  p1->id = m->idIncrementer++;
+  p1->index = 0;
+  while (m->parkTable[p1->index]) {
+    p1->index++;  // first free slot of the park table
   }
+  m->parkTable[p1->index] = p1;
+  p1->records = ListNew();
+  p1->revenue = revenueNew();
+  p1->bills = billsNew();
+  p1->history = historyNew();
+  p1->stats = statsNew();
+  topKInit(&p1->top[RANK_SPEND], RANK_SPEND);
+  topKInit(&p1->top[RANK_VISITS], RANK_VISITS);
+  namesAddPark(m, p1);
+  listAddPark(m->parks, p1);
+  eventsPublish(m, CM_ADD_PARK, p1, 0, capacity, 0, daily);
+  *added = p1;
+  return ST_OK;
 }
 
 /**
@@ -198,10 +643,10 @@ void processCommand_e(Memory *m, char *buffer) {
  * if arguments are provided. If no arguments, prints the existing parks.
  *
  * If the buffer is not empty, the function reads the park name, capacity,
- * and costs from the buffer. If the park name is found, it creates a new
- * park and adds it to the queue. If the park name is not found, it prints an
- * error message. If the capacity is not valid, it prints an error message.
- * If the costs are not valid, it prints an error message.
+ * and costs from the buffer and creates the park with `addPark`. If the park
+ * name is already used, it prints an error message. If the capacity is not
+ * valid, it prints an error message. If the costs are not valid, it prints
+ * an error message.
  *
  * @param m Pointer to the Memory structure, which contains the list of
  * parks.
@@ -210,25 +655,118 @@ void processCommand_e(Memory *m, char *buffer) {
  */
 void processCommand_p(Memory *m, char *buffer) {
   if (buffer[0]) {  // checking if buffer is empty
-    Park *p1 = malloc(sizeof(Park));
-    char *name = malloc(sizeof(char) * BUF_SIZE + 1);
-    p1->name = name;
-    p1->records = NULL;
+    char name[BUF_SIZE];
+    float less_60 = 0, more_60 = 0, dayly = 0;
+    int capacity = 0;
+    Park *p1;
     if (strchr(buffer, '\"')) {
-      sscanf(buffer, " \"%[^\"]\" %d %f %f %f", p1->name, &p1->capacity,
-             &p1->less_60, &p1->more_60, &p1->dayly);
+      sscanf(buffer, " \"%[^\"]\" %d %f %f %f", name, &capacity, &less_60,
+             &more_60, &dayly);
     } else {
-      sscanf(buffer, "%s %d %f %f %f", p1->name, &p1->capacity, &p1->less_60,
-             &p1->more_60, &p1->dayly);
+      sscanf(buffer, "%s %d %f %f %f", name, &capacity, &less_60, &more_60,
+             &dayly);
     }
-    if (validationsP(m, p1)) {
-      // everything is valid, adding park to the list
-      p1->occupancy = 0;
-      p1->id = m->idIncrementer++;
-      p1->records = ListNew();
-      listAddPark(m->parks, p1);
+    switch (addPark(m, name, capacity, toCents(less_60), toCents(more_60),
+                    toCents(dayly), &p1)) {
+      case ST_PARK_EXISTS:
+        reject(m, ERR_PARK_ALREADY_EXISTS(name));
+        break;
+      case ST_INVALID_CAPACITY:
+        reject(m, ERR_INVALID_CAPACITY(capacity));
+        break;
+      case ST_INVALID_COST:
+        reject(m, ERR_INVALID_COST);
+        break;
+      case ST_TOO_MANY_PARKS:
+        reject(m, ERR_TOO_MANY_PARKS);
+        break;
     }
-  } else {
-    printParks(m->parks);
+  } else if (m->output == OUTPUT_ALL) {
+    printParks(m->parks, m->out);
+  }
+}
+
+/**
+ * @brief Executes a command.
+ *
+ * This function executes a command based on the first character of the command
+ * string, after counting it. It uses a switch statement to determine which
+ * command to execute.
+ * The commands include adding a vehicle, getting bills, adding a park,
+ * removing a park, exiting a vehicle, importing records and exporting them,
+ * and the statistics of the parks.
+ * The command and the whole execution are each recorded as a span of the
+ * trace, and 'w' writes the trace.
+ *
+ * @param m A pointer to the Memory structure that contains the current state
+ * of the system.
+ * @param command The first character of the command string.
+ * @param buffer The command string.
+ */
+void execute(Memory *m, char command, char *buffer) {
+  long span = traceBegin(), commandSpan;
+  const char *name = NULL;
+  countCommand(m, command);
+  commandSpan = traceBegin();
+  switch (command) {  // sorting the command according to first char
+    case CM_ADD_VEHICLE:
+      processCommand_e(m, buffer);
+      name = "processCommand_e";
+      break;
+    case CM_GET_BILLS:
+      processCommand_f(m, buffer);
+      name = "processCommand_f";
+      break;
+    case CM_NETWORK_BILLS:
+      processCommand_n(m, buffer);
+      name = "processCommand_n";
+      break;
+    case CM_TOP_VEHICLES:
+      processCommand_t(m, buffer);
+      name = "processCommand_t";
+      break;
+    case CM_OCCUPANCY:
+      processCommand_o(m, buffer);
+      name = "processCommand_o";
+      break;
+    case CM_ADD_PARK:
+      processCommand_p(m, buffer);
+      name = "processCommand_p";
+      break;
+    case CM_REMOVE_PARK:
+      processCommand_r(m, buffer);
+      name = "processCommand_r";
+      break;
+    case CM_EXIT_VEHICLE:
+      processCommand_s(m, buffer);
+      name = "processCommand_s";
+      break;
+    case CM_PRINT_VEHICLES:
+      processCommand_v(m, buffer);
+      name = "processCommand_v";
+      break;
+    case CM_IMPORT:
+      processCommand_i(m, buffer);
+      name = "processCommand_i";
+      break;
+    case CM_EXPORT:
+      processCommand_x(m, buffer);
+      name = "processCommand_x";
+      break;
+    case CM_STATS:
+      processCommand_u(m, buffer);
+      name = "processCommand_u";
+      break;
+    case CM_OVERSTAYS:
+      processCommand_l(m, buffer);
+      name = "processCommand_l";
+      break;
+    case CM_WRITE_TRACE:
+      traceWrite();
+      break;
+  }
+  if (name) {
+    traceEnd(name, commandSpan);
   }
+  traceEnd("execute", span);
 }
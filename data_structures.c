@@ -8,6 +8,12 @@
  * calculating hash values. The hash table is used to store and retrieve
  * records efficiently.
  *
+ * Entries and exits may run at many gates at once. They hold the lock of the
+ * table shared, and the hash table only grows while it is held alone. A
+ * vehicle is changed only by who holds its lock, one of PLATE_STRIPES locks
+ * chosen by the plate, and a new vehicle is put in its slot with a compare
+ * and swap, as another vehicle may be taking the same slot.
+ *
  * @author Iuri Campos - 51948
  */
 #include <stdio.h>
@@ -17,19 +23,17 @@
 #include "project.h"
 
 /**
- * @brief Calculates the sum of the ASCII values of a string.
+ * @brief Scrambles an encoded license plate.
  *
- * This function calculates the sum of the ASCII values of a string using the
- * djb2 hash function algorithm. The sum is used as a key in the hash table.
+ * The encoded license plate is already a unique key, so it is only multiplied
+ * by a large odd constant (Fibonacci hashing) to spread consecutive plates
+ * over the hash table.
  *
- * @param str The string for which to calculate the sum of ASCII values.
- * @return Returns the sum of the ASCII values of the string.
+ * @param plate The encoded license plate.
+ * @return Returns the scrambled value of the license plate.
  */
-static Key sumAsciiValues(char* str) {
-  unsigned long hash = 5381;
-  int c;
-  while ((c = *str++)) hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-  return hash;
+static unsigned long scramblePlate(Plate plate) {
+  return (plate * 2654435769UL) >> 7;
 }
 
 /**
@@ -49,74 +53,396 @@ static int hash(Key value, int m) { return value % m; }
 /**
  * @brief Initializes a hash table.
  *
- * This function initializes a hash table by setting all of its entries to
+ * This function initializes a hash table with HASH_SIZE entries, all set to
  * NULL. It should be called before the hash table is used for the first time.
+ * The entries are mapped with `hugeAlloc`, as is the array of every resize.
  *
  * @param h A pointer to the hash table to be initialized.
  */
 void initializeHashTable(HashTable* h) {
-  for (int i = 0; i < HASH_SIZE; i++) {
-    h->plate[i] = NULL;
+  h->plate = hugeAlloc(HASH_SIZE * sizeof(HashNode*));
+  h->size = HASH_SIZE;
+  h->count = 0;
+}
+
+/**
+ * @brief Moves every node of a hash table into a new array.
+ *
+ * This function is used to grow the hash table and to close the gaps left in
+ * the probe sequences when nodes are removed.
+ *
+ * @param h A pointer to the hash table.
+ * @param size The number of entries of the new array.
+ */
+static void hashResize(HashTable* h, int size) {
+  HashNode** plate = hugeAlloc(size * sizeof(HashNode*));
+  for (int j = 0; j < h->size; j++) {
+    if (h->plate[j]) {
+      int i = hash(scramblePlate(h->plate[j]->key), size);
+      while (plate[i] != NULL) {
+        i = (i + 1) % size;
+      }
+      plate[i] = h->plate[j];
+    }
   }
+  hugeUnmap(h->plate, h->size * sizeof(HashNode*));
+  h->plate = plate;
+  h->size = size;
 }
 
 /**
- * @brief Adds a record to a hash table.
+ * @brief Makes sure a hash table can take more vehicles without growing.
  *
- * This function adds a record to a hash table. The record is added at the
- * index determined by the hash value of the license plate of the vehicle. If
- * there is a collision (i.e., if the calculated index is already occupied),
- * the function uses linear probing to find the next available index. The
- * record is inserted in a list.
+ * @param h A pointer to the hash table.
+ * @param count The number of vehicles about to be added.
+ */
+void hashReserve(HashTable* h, int count) {
+  int size = h->size;
+  while ((long)(h->count + count) * 2 >= size) {
+    size = size * 2 + 1;
+  }
+  if (size != h->size) {
+    hashResize(h, size);
+  }
+}
+
+/**
+ * @brief Adds a node to the marks of a vehicle.
  *
+ * The marks grow by doubling, so vehicles with fewer than VISIT_STRIDE + 1
+ * records have none allocated.
  *
- * @param h A pointer to the hash table to which the record is to be added.
- * @param r1 A pointer to the record to be added.
+ * @param n A pointer to the hash table node of the vehicle.
+ * @param node A pointer to the node of the list of records.
+ */
+static void addMark(HashNode* n, Node* node) {
+  if ((n->markCount & (n->markCount - 1)) == 0) {
+    int capacity = n->markCount ? n->markCount * 2 : 1;
+    n->marks = realloc(n->marks, sizeof(Node*) * capacity);
+  }
+  n->marks[n->markCount++] = node;
+}
+
+/**
+ * @brief Rebuilds the marks of a vehicle after records were removed.
+ *
+ * @param n A pointer to the hash table node of the vehicle.
+ */
+static void remarkRecords(HashNode* n) {
+  int i = 0;
+  n->markCount = 0;
+  n->dropped = 0;
+  for (Node* node = n->records->head; node; node = node->next, i++) {
+    if (i > 0 && i % VISIT_STRIDE == 0) {
+      addMark(n, node);
+    }
+  }
+}
+
+/**
+ * @brief Tells whether a vehicle keeps the oldest of its records.
+ *
+ * @param m A pointer to the Memory structure with the retention policy.
+ * @param l A pointer to the list of records of the vehicle.
+ * @param now The date and time of the newest record of the vehicle.
+ * @return Returns 1 if the policy keeps the record at the head of the list,
+ * or 0 if it may be dropped.
+ */
+static int keepsRecord(Memory* m, List* l, Stamp now) {
+  Record* r = l->head->item.record;
+  if (m->keepRecords && l->size > m->keepRecords) {
+    return 0;
+  }
+  return !m->keepDays || r->exit == NO_STAMP ||
+         STAMP_DAY(r->exit) >= STAMP_DAY(now) - m->keepDays;
+}
+
+/**
+ * @brief Drops the oldest records of a vehicle that the retention policy no
+ * longer keeps.
+ *
+ * A record is only dropped once it has ended, since its amount is then in the
+ * revenue index of its park, so the totals of commands 'f' and 'n' are not
+ * changed by it, and the billing lines of its day leave it out whether or not
+ * they are rendered yet, see `billsFreeze`. The open record is always kept.
+ * Its node is removed from the vehicle, as is its mark, and it is flagged
+ * RECORD_EVICTED and left in the list of its park, which removes it later
+ * under its own lock, see `compactRecords`. The park may be another one, so
+ * its count of dropped records is added to atomically, before the record is
+ * flagged, so that `compactRecords` never subtracts a record not counted.
+ *
+ * @param m A pointer to the Memory structure with the retention policy.
+ * @param n A pointer to the hash table node of the vehicle.
+ * @param now The date and time of the newest record of the vehicle.
  */
-void addRecord(HashTable* h, Record* r1) {
-  int i = hash(sumAsciiValues(r1->plates), HASH_SIZE);
-  while (h->plate[i] != NULL) {
-    if (sumAsciiValues(r1->plates) == h->plate[i]->key) {
-      listAddRecord(h->plate[i]->records, r1);
+static void retainRecords(Memory* m, HashNode* n, Stamp now) {
+  List* l = n->records;
+  while (l->size > 1 && !keepsRecord(m, l, now)) {
+    Node* head = l->head;
+    Record* r = head->item.record;
+    Park* p = m->parkTable[r->park];
+    if (r->exit == NO_STAMP) {
       break;
     }
-    i = (i + 1) % HASH_SIZE;
+    l->head = head->next;
+    l->size--;
+    if (n->markCount > 0 && n->marks[0] == head) {
+      memmove(n->marks, n->marks + 1, sizeof(Node*) * --n->markCount);
+    }
+    n->dropped++;
+    slabFree(&m->nodes, head);
+    __atomic_fetch_add(&p->evicted, 1, __ATOMIC_RELAXED);
+    __atomic_or_fetch(&r->flags, RECORD_EVICTED, __ATOMIC_RELEASE);
   }
-  if (h->plate[i] == NULL) {
-    HashNode* newNode = malloc(sizeof(HashNode));
-    h->plate[i] = newNode;
-    h->plate[i]->key = sumAsciiValues(r1->plates);
-    h->plate[i]->records = ListNew();
-    listAddRecord(h->plate[i]->records, r1);
+}
+
+/**
+ * @brief Adds a record to a hash table.
+ *
+ * This function adds a record to the list of records of its vehicle. A new
+ * vehicle is added at the index determined by the hash value of its license
+ * plate. If there is a collision (i.e., if the calculated index is already
+ * occupied), the function uses linear probing to find the next available
+ * index. The caller holds the lock of the vehicle and makes sure the table
+ * has room, see `lockTable`. The nodes and lists of the vehicles come from
+ * their slabs. The node of the record is added to the marks of the vehicle
+ * when it falls on one, and the vehicle then drops the records its retention
+ * policy no longer keeps, if there is one.
+ *
+ * @param m A pointer to the Memory structure with the hash table to which the
+ * record is to be added.
+ * @param r1 A pointer to the record to be added.
+ */
+void addRecord(Memory* m, Record* r1) {
+  HashTable* h = m->cars;
+  HashNode* newNode = getHashNode(h, r1->plate);
+  long position;
+  if (!newNode) {
+    HashNode* empty = NULL;
+    List* records = slabAlloc(&m->lists);
+    int i = hash(scramblePlate(r1->plate), h->size);
+    records->head = NULL;
+    records->tail = NULL;
+    records->size = 0;
+    newNode = slabAlloc(&m->vehicles);
+    newNode->key = r1->plate;
+    newNode->records = records;
+    newNode->parks = NULL;
+    newNode->marks = NULL;
+    newNode->markCount = 0;
+    newNode->dropped = 0;
+    newNode->timer = NULL;
+    tallyInit(&newNode->total, r1->plate, 0);
+    while (!__atomic_compare_exchange_n(&h->plate[i], &empty, newNode, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+      empty = NULL;
+      i = (i + 1) % h->size;
+    }
+    h->count++;
+  }
+  listAddRecord(&m->nodes, newNode->records, r1);
+  position = newNode->dropped + newNode->records->size - 1;
+  if (position % VISIT_STRIDE == 0 && position > 0) {
+    addMark(newNode, newNode->records->tail);
+  }
+  if (m->keepRecords || m->keepDays) {
+    retainRecords(m, newNode, r1->entry);
   }
 }
 
+/**
+ * @brief Retrieves the hash table node of a vehicle.
+ *
+ * This function calculates the hash value of the license plate and uses it to
+ * find the node of the vehicle in the hash table. If the node is not found at
+ * the calculated index, the function uses linear probing to search the rest
+ * of the hash table.
+ *
+ * @param h A pointer to the hash table.
+ * @param plate The encoded license plate of the vehicle.
+ * @return Returns a pointer to the node of the vehicle, or NULL if the vehicle
+ * is not in the hash table.
+ */
+HashNode* getHashNode(HashTable* h, Plate plate) {
+  if (plate == NO_PLATE) {
+    return NULL;
+  }
+  int i = hash(scramblePlate(plate), h->size);
+  HashNode* n;
+  while ((n = __atomic_load_n(&h->plate[i], __ATOMIC_ACQUIRE)) != NULL) {
+    if (plate == n->key) {
+      return n;
+    }
+    i = (i + 1) % h->size;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Takes the lock shared by entries and exits.
+ *
+ * If the hash table is half full, it is first grown, holding the lock alone.
+ * Each entry adds at most one vehicle, so the table cannot fill up while
+ * entries hold the lock.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+void lockTable(Memory* m) {
+  HashTable* h = m->cars;
+  pthread_rwlock_rdlock(&m->table);
+  while ((long)h->count * 2 >= h->size) {
+    pthread_rwlock_unlock(&m->table);
+    pthread_rwlock_wrlock(&m->table);
+    hashReserve(h, 1);
+    pthread_rwlock_unlock(&m->table);
+    pthread_rwlock_rdlock(&m->table);
+  }
+}
+
+/**
+ * @brief Releases the lock shared by entries and exits.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+void unlockTable(Memory* m) { pthread_rwlock_unlock(&m->table); }
+
+/**
+ * @brief Takes the lock of a vehicle, shared with the vehicles whose
+ * scrambled plates fall in the same stripe.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param plate The encoded license plate of the vehicle.
+ */
+void lockVehicle(Memory* m, Plate plate) {
+  pthread_mutex_lock(&m->stripes[scramblePlate(plate) % PLATE_STRIPES].lock);
+}
+
+/**
+ * @brief Releases the lock of a vehicle.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param plate The encoded license plate of the vehicle.
+ */
+void unlockVehicle(Memory* m, Plate plate) {
+  pthread_mutex_unlock(&m->stripes[scramblePlate(plate) % PLATE_STRIPES].lock);
+}
+
+/**
+ * @brief Prefetches one level of the entry of a vehicle in a hash table.
+ *
+ * Finding the last record of a vehicle goes through the slot of the hash
+ * table, the HashNode, its List, the tail Node and the Record, each one found
+ * from the previous. Prefetching one level for many vehicles before the next
+ * level overlaps their cache misses. Each level only reads what the previous
+ * level prefetched, and only the first slot of the probe sequence is
+ * followed, so a miss costs nothing but the prefetch.
+ *
+ * @param h A pointer to the hash table.
+ * @param plate The encoded license plate of the vehicle.
+ * @param level The level to prefetch, from 0, the slot, to
+ * PREFETCH_LEVELS - 1, the last record.
+ */
+void hashPrefetch(HashTable* h, Plate plate, int level) {
+  HashNode** slot = &h->plate[hash(scramblePlate(plate), h->size)];
+  HashNode* n;
+  Node* tail;
+  if (level == 0) {
+    __builtin_prefetch(slot);
+  } else if (!(n = *slot)) {
+    return;
+  } else if (level == 1) {
+    __builtin_prefetch(n);
+  } else if (n->key != plate) {
+    return;
+  } else if (level == 2) {
+    __builtin_prefetch(n->records);
+    __builtin_prefetch(n->parks);
+  } else if (!(tail = n->records->tail)) {
+    return;
+  } else if (level == 3) {
+    __builtin_prefetch(tail);
+  } else {
+    __builtin_prefetch(tail->item.record);
+  }
+}
+
+/**
+ * @brief Retrieves a park by id.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param id The id of the park.
+ * @return Returns a pointer to the park if found, or NULL if not found.
+ */
+Park* getParkById(Memory* m, int id) {
+  for (int i = 0; i < MAX_PARKS; i++) {
+    if (m->parkTable[i] && m->parkTable[i]->id == id) {
+      return m->parkTable[i];
+    }
+  }
+  return NULL;
+}
+
 /**
  * @brief Retrieves the list of records for a vehicle from a hash table.
  *
  * This function retrieves the list of records for a vehicle with a given
- * license plate from a hash table. The function calculates the hash value of
- * the license plate and uses it to find the corresponding record in the hash
- * table. If the record is not found at the calculated index, the function uses
- * linear probing to search the rest of the hash table.
+ * license plate from a hash table, using `getHashNode` to find the node of the
+ * vehicle.
  *
  * @param h A pointer to the hash table from which the record is to be
  * retrieved.
- * @param plates The license plate of the vehicle for which the record is to be
- * retrieved.
+ * @param plate The encoded license plate of the vehicle for which the record
+ * is to be retrieved.
  * @return Returns a pointer to the list of records for the vehicle if the
- * record is found, or NULL if the record is not found.
+ * record is found, or NULL if the record is not found or the vehicle has
+ * none left, see `removeParkRecords`.
+ */
+List* getListPlates(HashTable* h, Plate plate) {
+  HashNode* n = getHashNode(h, plate);
+  return n && n->records->size > 0 ? n->records : NULL;
+}
+/**
+ * @brief Checks whether a record ends before a day.
+ *
+ * @param r A pointer to the record.
+ * @param day The day.
+ * @return Returns 1 if the vehicle left before the day, or 0 otherwise.
  */
-List* getListPlates(HashTable* h, char* plates) {
-  int i = hash(sumAsciiValues(plates), HASH_SIZE);
-  while (h->plate[i] != NULL) {
-    if (sumAsciiValues(plates) == h->plate[i]->key) {
-      return h->plate[i]->records;
+static int endsBefore(Record* r, int day) {
+  return r->exit != NO_STAMP && STAMP_DAY(r->exit) < day;
+}
+
+/**
+ * @brief Finds the first record of a vehicle that ends on or after a day.
+ *
+ * A vehicle only enters again after it leaves, so the exits of its records
+ * are in order. The marks are searched by binary search for the last one
+ * that ends before the day, and from it at most VISIT_STRIDE records are
+ * walked, so the cost is logarithmic in the number of records.
+ *
+ * @param n A pointer to the hash table node of the vehicle.
+ * @param day The day.
+ * @return Returns a pointer to the node of the record, or NULL if every
+ * record ends before the day.
+ */
+Node* seekRecords(HashNode* n, int day) {
+  int low = 0, high = n->markCount;
+  Node* node;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if (endsBefore(n->marks[middle]->item.record, day)) {
+      low = middle + 1;
+    } else {
+      high = middle;
     }
-    i = (i + 1) % HASH_SIZE;
   }
-  return NULL;
+  node = low > 0 ? n->marks[low - 1] : n->records->head;
+  while (node && endsBefore(node->item.record, day)) {
+    node = node->next;
+  }
+  return node;
 }
+
 /**
  * @brief Retrieves the last record for a vehicle from a hash table.
  *
@@ -127,13 +453,13 @@ List* getListPlates(HashTable* h, char* plates) {
  *
  * @param h A pointer to the hash table from which the record is to be
  * retrieved.
- * @param plates The license plate of the vehicle for which the record is to be
- * retrieved.
+ * @param plate The encoded license plate of the vehicle for which the record
+ * is to be retrieved.
  * @return Returns a pointer to the last record for the vehicle if the record
  * is found, or NULL if the record is not found.
  */
-Record* getLastRecord(HashTable* h, char* plates) {
-  List* l = getListPlates(h, plates);
+Record* getLastRecord(HashTable* h, Plate plate) {
+  List* l = getListPlates(h, plate);
   if (l) {
     return l->tail->item.record;
   }
@@ -190,11 +516,12 @@ void listAddPark(List* l, Park* p) {
  * new node. Otherwise, the new node is added after the current tail, and the
  * tail pointer is updated to the new node.
  *
+ * @param s A pointer to the slab of the nodes.
  * @param l A pointer to the list to which the record is to be added.
  * @param r A pointer to the record to be added.
  */
-void listAddRecord(List* l, Record* r) {
-  Node* n = malloc(sizeof(Node));
+void listAddRecord(Slab* s, List* l, Record* r) {
+  Node* n = slabAlloc(s);
   n->item.record = r;
   n->next = NULL;
   if (l->size == 0) {
@@ -206,28 +533,6 @@ void listAddRecord(List* l, Record* r) {
   }
   l->size++;
 }
-/**
- * @brief Retrieves a park from a list by name.
- *
- * This function retrieves a park from a list by name. It iterates over the
- * list and returns the first park that matches the given name. If no park with
- * the given name is found, the function returns NULL.
- *
- * @param l A pointer to the list from which the park is to be retrieved.
- * @param name The name of the park to be retrieved.
- * @return Returns a pointer to the park if found, or NULL if not found.
- */
-Park* listGetPark(List* l, char* name) {
-  Node* n = l->head;
-  while (n != NULL) {
-    if (strcmp(n->item.park->name, name) == 0) {
-      return n->item.park;
-    }
-    n = n->next;
-  }
-  return 0;
-}
-
 /**
  * @brief Removes a record from a list.
  *
@@ -237,12 +542,14 @@ Park* listGetPark(List* l, char* name) {
  * node. If the node to be removed is the tail of the list, the tail pointer is
  * updated to the previous node. If the node is in the middle of the list, the
  * previous node's next pointer and the next node's previous pointer are
- * updated to skip over the removed node.
+ * updated to skip over the removed node. The record and the node are returned
+ * to their slabs.
  *
+ * @param m A pointer to the Memory structure with the slabs.
  * @param l A pointer to the list from which the record is to be removed.
  * @param r A pointer to the record to be removed.
  */
-static void listRemoveRecord(List* l, Record* r) {
+static void listRemoveRecord(Memory* m, List* l, Record* r) {
   Node* prev = NULL;
   Node* n = l->head;
   while (n) {
@@ -256,8 +563,8 @@ static void listRemoveRecord(List* l, Record* r) {
       if (n == l->tail) {
         l->tail = prev;
       }
-      free(n->item.record);
-      free(n);
+      slabFree(&m->records, n->item.record);
+      slabFree(&m->nodes, n);
       l->size--;
       break;
     }
@@ -266,6 +573,54 @@ static void listRemoveRecord(List* l, Record* r) {
   }
 }
 
+/**
+ * @brief Removes the records dropped by their vehicles from the list of a
+ * park.
+ *
+ * The records and their nodes are returned to their slabs. The caller holds
+ * the lock of the park. If the node of the last record rendered in the
+ * billing text is removed, the last record kept before it takes its place,
+ * and the billing text of the exits is rendered again without the lines of
+ * the records removed, see `billsRebuild`.
+ *
+ * @param m A pointer to the Memory structure with the slabs.
+ * @param p A pointer to the park.
+ */
+void compactRecords(Memory* m, Park* p) {
+  List* l = p->records;
+  Node* prev = NULL;
+  Node* n = l->head;
+  int removed = 0;
+  while (n) {
+    Node* next = n->next;
+    if (__atomic_load_n(&n->item.record->flags, __ATOMIC_ACQUIRE) &
+        RECORD_EVICTED) {
+      if (prev) {
+        prev->next = next;
+      } else {
+        l->head = next;
+      }
+      if (n == l->tail) {
+        l->tail = prev;
+      }
+      if (n == p->bills->last) {
+        p->bills->last = prev;
+      }
+      slabFree(&m->records, n->item.record);
+      slabFree(&m->nodes, n);
+      l->size--;
+      removed++;
+    } else {
+      prev = n;
+    }
+    n = next;
+  }
+  if (removed > 0) {
+    billsRebuild(p);
+  }
+  __atomic_fetch_sub(&p->evicted, removed, __ATOMIC_RELAXED);
+}
+
 /**
  * @brief Removes all records associated with a specific park from the hash
  * table.
@@ -273,50 +628,74 @@ static void listRemoveRecord(List* l, Record* r) {
  * This function iterates over the hash table and removes all records
  * associated with a specific park. It does this by iterating over each list of
  * records in the hash table, and removing any records that match the given
- * park ID.
+ * park. The totals and the timers of the vehicles in the park are also
+ * removed, and the marks of the vehicles that lost records are rebuilt. Vehicles left without
+ * records are removed, unless they still have totals in other parks, whose
+ * records they dropped, see `retainRecords`, and the hash table is then
+ * rebuilt so that no probe sequence is broken by their empty entries.
  *
  * @param m A pointer to the Memory structure that contains the hash table.
- * @param parkId The ID of the park for which the records are to be removed.
+ * @param p A pointer to the park for which the records are to be removed.
  */
-static void removeParkRecords(Memory* m, int parkId) {
-  for (int i = 0; i < HASH_SIZE; i++) {
-    if (m->cars->plate[i]) {
-      Node* n = m->cars->plate[i]->records->head;
+static void removeParkRecords(Memory* m, Park* p) {
+  HashTable* h = m->cars;
+  long span = traceBegin();
+  int removed = 0;
+  for (int i = 0; i < h->size; i++) {
+    if (h->plate[i]) {
+      Node* n = h->plate[i]->records->head;
+      int size = h->plate[i]->records->size;
+      rankRemovePark(h->plate[i], p->id);
+      if (h->plate[i]->timer && h->plate[i]->timer->record->park == p->index) {
+        wheelCancel(m, h->plate[i]);
+      }
       while (n) {
         Node* next = n->next;
-        if (n->item.record->park->id == parkId) {
-          listRemoveRecord(m->cars->plate[i]->records, n->item.record);
+        if (n->item.record->park == p->index) {
+          listRemoveRecord(m, h->plate[i]->records, n->item.record);
         }
         n = next;
       }
-      if (m->cars->plate[i]->records->size == 0) {
-        free(m->cars->plate[i]->records);
-        free(m->cars->plate[i]);
-        m->cars->plate[i] = NULL;
+      if (h->plate[i]->records->size == 0 && !h->plate[i]->parks) {
+        slabFree(&m->lists, h->plate[i]->records);
+        freeTallies(h->plate[i]);
+        free(h->plate[i]->marks);
+        slabFree(&m->vehicles, h->plate[i]);
+        h->plate[i] = NULL;
+        removed++;
+      } else if (h->plate[i]->records->size != size) {
+        remarkRecords(h->plate[i]);
       }
     }
   }
+  if (removed) {
+    h->count -= removed;
+    hashResize(h, h->size);
+  }
+  traceEnd("removeParkRecords", span);
 }
 /**
  * @brief Removes a park from the list of parks and all its records from
  * hashtable.
  *
  * This function removes a park with a given ID from the list of parks and the
- * hash table. It first calls the `removeParkRecords` function to remove all
- * records associated with the park from the hash table. Then it iterates over
- * the list of parks and removes the park. If the park to be removed is the
+ * hash table. It iterates over the list of parks and removes the park. Then
+ * it calls the `removeParkRecords` function to remove all records associated
+ * with the park from the hash table, frees its slot in the park table and
+ * removes it from the index of parks by name. If the park to be removed is the
  * head of the list, the head pointer is updated to the next park. If the park
  * to be removed is the tail of the list, the tail pointer is updated to the
  * previous park. If the park is in the middle of the list, the previous park's
  * next pointer and the next park's previous pointer are updated to skip over
- * the removed park.
+ * the removed park. Finally, the network rankings are rebuilt, since the
+ * totals of the vehicles in the park have been removed, and the removal is
+ * published to the event ring.
  *
  * @param m A pointer to the Memory structure that contains the list of parks
  * and the hash table.
  * @param parkId The ID of the park to be removed.
  */
 void removePark(Memory* m, int parkId) {
-  removeParkRecords(m, parkId);
   Node* prev = NULL;
   Node* n = m->parks->head;
   while (n) {  // removing Park from List
@@ -336,6 +715,12 @@ void removePark(Memory* m, int parkId) {
     prev = n;
     n = next;
   }
-  freePark(n->item.park);
+  eventsPublish(m, CM_REMOVE_PARK, n->item.park, 0, 0, 0, 0);
+  compactRecords(m, n->item.park);
+  removeParkRecords(m, n->item.park);
+  m->parkTable[n->item.park->index] = NULL;
+  namesRemovePark(m, n->item.park);
+  freePark(&m->nodes, n->item.park);
   free(n);
+  rankRebuild(m);
 }
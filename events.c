@@ -0,0 +1,218 @@
+/**
+ * @file events.c
+ * @brief Source file for the ring of change events in shared memory.
+ *
+ * This file contains the implementation of the event ring, selected with the
+ * option -e. Every change accepted by the program, from any input, is
+ * published as a 64-byte Event to a ring in POSIX shared memory, which other
+ * local processes map and read in place, without copies and without
+ * anything that could make the program wait for them:
+ *
+ * - 'e': `park`, `plate`, the entry in `a` and the free spots left in `b`.
+ * - 's': `park`, `plate`, the exit in `a`, the entry in `b` and the amount
+ *   paid, in cents, in `amount`.
+ * - 'p': `park`, the capacity in `a`, the daily price in `amount` and the
+ *   name in `name`.
+ * - 'r': `park`.
+ * - 'l': `park`, `plate`, the minute the vehicle started to overstay in `a`
+ *   and its entry in `b`, see wheel.c.
+ *
+ * The program writes event `n` to `events[n % capacity]`, setting its
+ * sequence to 0 before and to `n + 1` after, and then sets `head` to `n + 1`.
+ * A reader checks the sequence of an event before and after reading it, so
+ * an event overwritten while it was read is detected. A reader that falls
+ * more than `capacity` events behind loses the oldest ones, and is told how
+ * many.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "project.h"
+
+/**
+ * @brief Creates the event ring, empty.
+ *
+ * @param name The name of the shared memory object, as in "/park-events".
+ * @return Returns a pointer to the event ring, or NULL if it cannot be
+ * created.
+ */
+EventRing *eventsCreate(const char *name) {
+  size_t size = sizeof(EventRing) + EVENT_RING_SIZE * sizeof(Event);
+  EventRing *ring;
+  int fd = shm_open(name, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) {
+    shm_unlink(name);
+    return NULL;
+  }
+  ring->capacity = EVENT_RING_SIZE;
+  atomic_store(&ring->closed, 0);
+  atomic_store(&ring->head, 0);
+  atomic_store_explicit(&ring->magic, EVENT_MAGIC, memory_order_release);
+  return ring;
+}
+
+/**
+ * @brief Marks the event ring as closed, so readers stop once they read the
+ * last event, and removes it.
+ *
+ * Readers that already mapped it can still read it.
+ *
+ * @param ring A pointer to the event ring.
+ * @param name The name it was created with.
+ */
+void eventsClose(EventRing *ring, const char *name) {
+  atomic_store_explicit(&ring->closed, 1, memory_order_release);
+  munmap(ring, sizeof(EventRing) + ring->capacity * sizeof(Event));
+  shm_unlink(name);
+}
+
+/**
+ * @brief Publishes a change to the event ring, if there is one.
+ *
+ * The ring has a single writer, so changes made at many gates at once are
+ * published one at a time, holding the network lock.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param op The command of the change.
+ * @param p A pointer to the park changed.
+ * @param plate The encoded license plate, or 0.
+ * @param a The first value, see the start of this file.
+ * @param b The second value.
+ * @param amount The amount of money.
+ */
+void eventsPublish(Memory *m, uint8_t op, Park *p, Plate plate, uint32_t a,
+                   uint32_t b, Cents amount) {
+  EventRing *ring = m->events;
+  uint64_t n;
+  Event *e;
+  if (!ring) {
+    return;
+  }
+  pthread_mutex_lock(&m->lock);
+  n = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  e = &ring->events[n & (ring->capacity - 1)];
+  atomic_store_explicit(&e->sequence, 0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  e->op = op;
+  e->park = p->id;
+  e->plate = plate;
+  e->a = a;
+  e->b = b;
+  e->amount = amount;
+  if (op == CM_ADD_PARK) {
+    strncpy(e->name, p->name, EVENT_NAME - 1);
+    e->name[EVENT_NAME - 1] = '\0';
+  } else {
+    e->name[0] = '\0';
+  }
+  atomic_store_explicit(&e->sequence, n + 1, memory_order_release);
+  atomic_store_explicit(&ring->head, n + 1, memory_order_release);
+  pthread_mutex_unlock(&m->lock);
+}
+
+/**
+ * @brief Maps an event ring to read it, from its next event.
+ *
+ * @param r A pointer to the reader.
+ * @param name The name of the shared memory object.
+ * @return Returns 1 if the event ring was mapped, or 0 if it cannot be.
+ */
+int eventsAttach(EventReader *r, const char *name) {
+  struct stat info;
+  const EventRing *ring;
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(EventRing)) {
+    close(fd);
+    return 0;
+  }
+  ring = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED) {
+    return 0;
+  }
+  if (atomic_load_explicit(&ring->magic, memory_order_acquire) !=
+          EVENT_MAGIC ||
+      info.st_size < (off_t)(sizeof(EventRing) +
+                             ring->capacity * sizeof(Event))) {
+    munmap((void *)ring, info.st_size);
+    return 0;
+  }
+  r->ring = ring;
+  r->size = info.st_size;
+  r->next = atomic_load_explicit(&ring->head, memory_order_acquire);
+  return 1;
+}
+
+/**
+ * @brief Gets the next event, in place.
+ *
+ * The event may be overwritten while it is read, so what is read from it is
+ * only valid if `eventsDone` then returns 1.
+ *
+ * @param r A pointer to the reader.
+ * @param lost A pointer to where the number of events lost, overwritten
+ * before they were read, is added.
+ * @return Returns a pointer to the event, or NULL if there is none yet.
+ */
+const Event *eventsPeek(EventReader *r, uint64_t *lost) {
+  const EventRing *ring = r->ring;
+  for (;;) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    const Event *e = &ring->events[r->next & (ring->capacity - 1)];
+    if (r->next == head) {
+      return NULL;
+    } else if (head - r->next > ring->capacity) {
+      *lost += head - ring->capacity - r->next;
+      r->next = head - ring->capacity;
+    } else if (atomic_load_explicit(&e->sequence, memory_order_acquire) !=
+               r->next + 1) {
+      *lost += 1;
+      r->next++;
+    } else {
+      return e;
+    }
+  }
+}
+
+/**
+ * @brief Finishes reading an event, moving to the next one.
+ *
+ * @param r A pointer to the reader.
+ * @param e A pointer to the event, from `eventsPeek`.
+ * @return Returns 1 if the event was not overwritten while it was read, or
+ * 0 if what was read from it must be discarded.
+ */
+int eventsDone(EventReader *r, const Event *e) {
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&e->sequence, memory_order_relaxed) !=
+      r->next + 1) {
+    return 0;
+  }
+  r->next++;
+  return 1;
+}
+
+/**
+ * @brief Unmaps the event ring of a reader.
+ *
+ * @param r A pointer to the reader.
+ */
+void eventsDetach(EventReader *r) { munmap((void *)r->ring, r->size); }
@@ -0,0 +1,339 @@
+/**
+ * @file export.c
+ * @brief Source file for the export of the history of records.
+ *
+ * This file contains the implementation of command 'x', which writes every
+ * record of the parks to a file, park by park in the order they were added:
+ * first the stays that ended, in the order of their exits, then the vehicles
+ * still inside. Each park is walked in its own list of records, and the
+ * vehicles inside are found in one pass over the hash table, so no record is
+ * looked up. The records dropped by their vehicles are not exported.
+ *
+ * The file is binary unless `csv` is given. A binary file starts with
+ * EXPORT_MAGIC and the table of park names, as in the binary import files, and
+ * holds the rows in blocks of up to EXPORT_BLOCK. Each block has a 16-byte
+ * header, with its number of rows, its smallest and largest park and its
+ * first and last day, followed by one column after the other: the parks, the
+ * plates, the entries, the exits and the amounts paid, each of fixed width.
+ * A reader can skip a block by its header alone, and read only the columns
+ * it needs. Columns are filled in memory and each one is written with a
+ * single call. A CSV file has a header line and one
+ * `<park-name>,<plate>,<entry>,<exit>,<paid>` line per row, as in the import
+ * files, with the exit and the amount empty for vehicles still inside and the
+ * park name quoted as in RFC 4180 when it needs to be.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+#define EXPORT_MAGIC "PKEX"       /*First bytes of a binary export file*/
+#define EXPORT_BLOCK (1 << 16)    /*Rows in each block of a binary file*/
+#define EXPORT_IO_SIZE (1 << 22)  /*Size of the write buffer of the file*/
+
+/**
+ * @brief Structure to hold the header of a block of a binary export file.
+ *
+ * @param rows The number of rows in the block.
+ * @param minPark The smallest park of the rows, by its place in the names.
+ * @param maxPark The largest park of the rows.
+ * @param minDay The day of the earliest entry of the rows.
+ * @param maxDay The day of the latest exit, or entry if there is no exit.
+ */
+typedef struct {
+  uint32_t rows;
+  uint16_t minPark, maxPark;
+  uint32_t minDay, maxDay;
+} Block;
+
+/**
+ * @brief Structure to hold an open export file.
+ *
+ * @param f The file.
+ * @param csv Whether the file is CSV.
+ * @param rows The number of rows written.
+ * @param numbers The place of each park in the names, by park index.
+ * @param head The header of the current block.
+ * @param parks The park column of the current block.
+ * @param plates The plate column of the current block.
+ * @param entries The entry column of the current block.
+ * @param exits The exit column of the current block, NO_STAMP for vehicles
+ * still inside.
+ * @param paid The column of the amounts paid of the current block.
+ * @param days The days last formatted for CSV, entry and exit.
+ * @param dates The text of `days`.
+ */
+typedef struct {
+  FILE *f;
+  int csv;
+  long rows;
+  uint16_t numbers[MAX_PARKS];
+  Block head;
+  uint16_t parks[EXPORT_BLOCK];
+  Plate plates[EXPORT_BLOCK];
+  Stamp entries[EXPORT_BLOCK], exits[EXPORT_BLOCK];
+  int64_t paid[EXPORT_BLOCK];
+  int days[2];
+  char dates[2][11];
+} Exporter;
+
+/**
+ * @brief Writes the current block of a binary export file, if it has rows.
+ *
+ * @param ex A pointer to the exporter.
+ */
+static void exportFlush(Exporter *ex) {
+  uint32_t n = ex->head.rows;
+  if (n == 0) {
+    return;
+  }
+  fwrite(&ex->head, sizeof(Block), 1, ex->f);
+  fwrite(ex->parks, sizeof(uint16_t), n, ex->f);
+  fwrite(ex->plates, sizeof(Plate), n, ex->f);
+  fwrite(ex->entries, sizeof(Stamp), n, ex->f);
+  fwrite(ex->exits, sizeof(Stamp), n, ex->f);
+  fwrite(ex->paid, sizeof(int64_t), n, ex->f);
+  ex->head.rows = 0;
+}
+
+/**
+ * @brief Adds a row to the current block of a binary export file, writing
+ * the block when it is full.
+ *
+ * @param ex A pointer to the exporter.
+ * @param park The place of the park in the names.
+ * @param r A pointer to the record.
+ * @param paid The amount paid.
+ */
+static void exportColumns(Exporter *ex, uint16_t park, Record *r, Cents paid) {
+  Block *b = &ex->head;
+  uint32_t first = STAMP_DAY(r->entry);
+  uint32_t last = STAMP_DAY(r->exit != NO_STAMP ? r->exit : r->entry);
+  if (b->rows == 0) {
+    b->minPark = b->maxPark = park;
+    b->minDay = first;
+    b->maxDay = last;
+  }
+  b->minPark = park < b->minPark ? park : b->minPark;
+  b->maxPark = park > b->maxPark ? park : b->maxPark;
+  b->minDay = first < b->minDay ? first : b->minDay;
+  b->maxDay = last > b->maxDay ? last : b->maxDay;
+  ex->parks[b->rows] = park;
+  ex->plates[b->rows] = r->plate;
+  ex->entries[b->rows] = r->entry;
+  ex->exits[b->rows] = r->exit;
+  ex->paid[b->rows] = paid;
+  if (++b->rows == EXPORT_BLOCK) {
+    exportFlush(ex);
+  }
+}
+
+/**
+ * @brief Formats the date of a stamp, reusing the text of the last day
+ * formatted in the same column, since consecutive rows share their days.
+ *
+ * @param ex A pointer to the exporter.
+ * @param column The column, 0 for entries and 1 for exits.
+ * @param stamp The date and time.
+ * @return Returns the date as dd-mm-yyyy.
+ */
+static const char *exportDate(Exporter *ex, int column, Stamp stamp) {
+  if (ex->days[column] != STAMP_DAY(stamp)) {
+    ex->days[column] = STAMP_DAY(stamp);
+    intToDate(ex->days[column], ex->dates[column]);
+  }
+  return ex->dates[column];
+}
+
+/**
+ * @brief Writes a park name as a CSV field, as RFC 4180 has it: in quotes if
+ * it has a comma, a quote or a line break, with each quote doubled.
+ *
+ * @param f The file.
+ * @param name The name.
+ */
+static void exportName(FILE *f, const char *name) {
+  if (!name[strcspn(name, ",\"\r\n")]) {
+    fputs(name, f);
+    return;
+  }
+  fputc('"', f);
+  for (const char *c = name; *c; c++) {
+    if (*c == '"') {
+      fputc('"', f);
+    }
+    fputc(*c, f);
+  }
+  fputc('"', f);
+}
+
+/**
+ * @brief Writes a row to a CSV export file.
+ *
+ * @param ex A pointer to the exporter.
+ * @param p A pointer to the park.
+ * @param r A pointer to the record.
+ * @param paid The amount paid.
+ */
+static void exportLine(Exporter *ex, Park *p, Record *r, Cents paid) {
+  char plates[9], entry[6], exit[6];
+  decodePlate(r->plate, plates);
+  intToTime(STAMP_TIME(r->entry), entry);
+  exportName(ex->f, p->name);
+  fprintf(ex->f, ",%s,%s %s,", plates, exportDate(ex, 0, r->entry), entry);
+  if (r->exit == NO_STAMP) {
+    fputs(",\n", ex->f);
+  } else {
+    intToTime(STAMP_TIME(r->exit), exit);
+    fprintf(ex->f, "%s %s," CENTS_FMT "\n", exportDate(ex, 1, r->exit), exit,
+            CENTS_ARG(paid));
+  }
+}
+
+/**
+ * @brief Writes a row to an export file.
+ *
+ * @param ex A pointer to the exporter.
+ * @param p A pointer to the park of the record.
+ * @param r A pointer to the record.
+ */
+static void exportRow(Exporter *ex, Park *p, Record *r) {
+  Cents paid = r->exit != NO_STAMP ? calculatePrice(p, r) : 0;
+  if (ex->csv) {
+    exportLine(ex, p, r, paid);
+  } else {
+    exportColumns(ex, ex->numbers[p->index], r, paid);
+  }
+  ex->rows++;
+}
+
+/**
+ * @brief Writes the header of an export file.
+ *
+ * The parks are numbered in the order they were added, as in the names of a
+ * binary file.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param ex A pointer to the exporter.
+ */
+static void exportHeader(Memory *m, Exporter *ex) {
+  uint32_t count = m->parks->size;
+  uint16_t number = 0, length;
+  if (ex->csv) {
+    fputs("park,plate,entry,exit,paid\n", ex->f);
+  } else {
+    fwrite(EXPORT_MAGIC, 1, 4, ex->f);
+    fwrite(&count, sizeof(count), 1, ex->f);
+  }
+  for (Node *n = m->parks->head; n; n = n->next) {
+    ex->numbers[n->item.park->index] = number++;
+    if (!ex->csv) {
+      length = strlen(n->item.park->name);
+      fwrite(&length, sizeof(length), 1, ex->f);
+      fwrite(n->item.park->name, 1, length, ex->f);
+    }
+  }
+}
+
+/**
+ * @brief Finds the records of the vehicles inside the parks.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param inside Where the records are stored, by park index, each array
+ * sized for the occupancy of its park.
+ * @param counts Where the number of records of each park is stored.
+ */
+static void findInside(Memory *m, Record **inside[], int counts[]) {
+  HashTable *h = m->cars;
+  for (int i = 0; i < h->size; i++) {
+    Record *r;
+    if (!h->plate[i] || h->plate[i]->records->size == 0) {
+      continue;
+    }
+    r = h->plate[i]->records->tail->item.record;
+    if (r->exit == NO_STAMP && inside[r->park] &&
+        counts[r->park] < m->parkTable[r->park]->occupancy) {
+      inside[r->park][counts[r->park]++] = r;
+    }
+  }
+}
+
+/**
+ * @brief Writes every record of the parks to an export file.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param ex A pointer to the exporter.
+ */
+static void exportRecords(Memory *m, Exporter *ex) {
+  Record **inside[MAX_PARKS] = {NULL};
+  int counts[MAX_PARKS] = {0};
+  for (Node *n = m->parks->head; n; n = n->next) {
+    Park *p = n->item.park;
+    inside[p->index] = malloc(sizeof(Record *) * (p->occupancy + 1));
+  }
+  findInside(m, inside, counts);
+  exportHeader(m, ex);
+  for (Node *n = m->parks->head; n; n = n->next) {
+    Park *p = n->item.park;
+    for (Node *r = p->records->head; r; r = r->next) {
+      if (!(r->item.record->flags & RECORD_EVICTED)) {
+        exportRow(ex, p, r->item.record);
+      }
+    }
+    for (int i = 0; i < counts[p->index]; i++) {
+      exportRow(ex, p, inside[p->index][i]);
+    }
+    free(inside[p->index]);
+  }
+  if (!ex->csv) {
+    exportFlush(ex);
+  }
+}
+
+/**
+ * @brief Processes command 'x', exporting every record to a file.
+ *
+ * The file is written in binary columns, or as CSV if the path is followed
+ * by `csv`. The number of records exported is printed.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks
+ * and records.
+ * @param buffer Buffer containing the path of the file and its format.
+ * @return void
+ */
+void processCommand_x(Memory *m, char *buffer) {
+  char path[BUF_SIZE] = "", format[BUF_SIZE] = "";
+  Exporter *ex;
+  int failed;
+  if (strchr(buffer, '\"')) {
+    sscanf(buffer, " \"%[^\"]\" %s", path, format);
+  } else {
+    sscanf(buffer, "%s %s", path, format);
+  }
+  if (format[0] && strcmp(format, "csv")) {
+    reject(m, ERR_INVALID_FORMAT);
+    return;
+  }
+  ex = malloc(sizeof(Exporter));
+  ex->csv = format[0] != '\0';
+  ex->rows = 0;
+  ex->head.rows = 0;
+  ex->days[0] = ex->days[1] = -1;
+  if (!(ex->f = fopen(path, "wb"))) {
+    reject(m, ERR_CANNOT_OPEN(path));
+    free(ex);
+    return;
+  }
+  setvbuf(ex->f, NULL, _IOFBF, EXPORT_IO_SIZE);
+  exportRecords(m, ex);
+  failed = ferror(ex->f);
+  if (fclose(ex->f) || failed) {
+    reject(m, ERR_CANNOT_WRITE(path));
+  } else if (m->output == OUTPUT_ALL) {
+    fprintf(m->out, "%s: %ld records exported.\n", path, ex->rows);
+  }
+  free(ex);
+}
@@ -0,0 +1,765 @@
+/**
+ * @file import.c
+ * @brief Source file for the bulk import of historical records.
+ *
+ * This file contains the implementation of command 'i', which loads entries
+ * and exits from a file sorted by entry date. The file is either text, with
+ * one `park,plate,entry,exit` row per line, or binary, starting with
+ * IMPORT_MAGIC, a table of park names and then one 16-byte record per row.
+ * The file is read twice: the first pass validates every row against the
+ * state of the system and the rows before it, without changing anything, and
+ * the second pass builds the records in bulk, with the slab and the hash table
+ * sized up front. Exits are applied in chronological order with a queue of
+ * pending departures per park, so the revenue index, the occupancy history,
+ * the statistics and the rankings end up as if the rows had been entered one
+ * by one. Nothing is printed per row, only an error or a single summary line.
+ * The rows imported can also be written out as a binary import file, which
+ * the server logs so its replicas import the same rows, see snapshot.c.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+#define IMPORT_MAGIC "PKIM"         /*First bytes of a binary import file*/
+#define IMPORT_IO_SIZE (1 << 20)    /*Size of the read buffer of the file*/
+#define NEVER UINT32_MAX            /*Departure of a vehicle that stays*/
+
+/**
+ * @brief Structure to hold a vehicle leaving a park during the import.
+ *
+ * @param exit The minute the vehicle leaves.
+ * @param seq The row of the stay, to break ties in file order.
+ * @param r A pointer to the record of the stay, or NULL while validating.
+ */
+typedef struct {
+  Stamp exit;
+  long seq;
+  Record *r;
+} Departure;
+
+/**
+ * @brief Structure to hold the pending departures of a park, as a min-heap.
+ *
+ * @param heap The departures, the earliest one at the root.
+ * @param size The number of departures.
+ * @param capacity The number of departures allocated.
+ */
+typedef struct {
+  Departure *heap;
+  int size, capacity;
+} Departures;
+
+/**
+ * @brief Structure to hold the last exit of each vehicle seen in the file.
+ *
+ * @param plates The license plates, NO_PLATE in empty slots.
+ * @param exits The last exit of each vehicle, NO_STAMP if it is still inside.
+ * @param size The number of slots.
+ * @param count The number of vehicles.
+ */
+typedef struct {
+  Plate *plates;
+  Stamp *exits;
+  long size, count;
+} Visits;
+
+/**
+ * @brief Structure to hold a row of the import file.
+ *
+ * @param park A pointer to the park, or NULL if there is no such park.
+ * @param plate The encoded license plate, or NO_PLATE if it is not valid.
+ * @param entry The minute the vehicle entered the park.
+ * @param exit The minute the vehicle left the park, or NO_STAMP.
+ * @param name The name of the park, for error messages.
+ * @param plates The license plate as text, for error messages.
+ */
+typedef struct {
+  Park *park;
+  Plate plate;
+  Stamp entry, exit;
+  char *name;
+  char plates[9];
+} Row;
+
+/**
+ * @brief Structure to hold an open import file.
+ *
+ * @param f The file.
+ * @param path The path of the file, for error messages.
+ * @param binary Whether the file is binary.
+ * @param start The position of the first row in the file.
+ * @param line The number of the current line, or row in binary files.
+ * @param names The park names of a binary file.
+ * @param parks The park of each name of a binary file, or NULL.
+ * @param parkCount The number of park names of a binary file.
+ * @param buffer The current line of a text file.
+ */
+typedef struct {
+  FILE *f;
+  char *path;
+  int binary;
+  long start, line;
+  char **names;
+  Park **parks;
+  int parkCount;
+  char buffer[BUF_SIZE + 2];
+} Importer;
+
+/**
+ * @brief Prints the location of an error in the import file, unless errors
+ * are only counted.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param im A pointer to the importer.
+ */
+static void importError(Memory *m, Importer *im) {
+  if (m->output != OUTPUT_NONE) {
+    fprintf(m->out, ERR_IMPORT_LINE(im->path, im->line));
+  }
+}
+
+/**
+ * @brief Reads a little-endian number.
+ *
+ * @param f The stream.
+ * @param bytes The number of bytes.
+ * @param value A pointer to where the number is stored.
+ * @return Returns 1 if the number was read, or 0 at the end of the stream.
+ */
+static int getLittle(FILE *f, int bytes, uint32_t *value) {
+  uint8_t buffer[4];
+  if (fread(buffer, 1, bytes, f) != (size_t)bytes) {
+    return 0;
+  }
+  *value = 0;
+  for (int i = bytes - 1; i >= 0; i--) {
+    *value = *value << 8 | buffer[i];
+  }
+  return 1;
+}
+
+/**
+ * @brief Starts reading an import file and reads the header of binary files.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param im A pointer to the importer.
+ * @param f The file, or NULL if it could not be opened.
+ * @param path The path of the file.
+ * @return Returns 1 if the file is ready to be read, or 0 after printing an
+ * error.
+ */
+static int importOpen(Memory *m, Importer *im, FILE *f, char *path) {
+  char magic[4];
+  uint32_t count, length;
+  im->f = f;
+  im->path = path;
+  im->names = NULL;
+  im->parks = NULL;
+  im->parkCount = 0;
+  im->line = 0;
+  if (!im->f) {
+    reject(m, ERR_CANNOT_OPEN(path));
+    return 0;
+  }
+  setvbuf(im->f, NULL, _IOFBF, IMPORT_IO_SIZE);
+  im->binary = fread(magic, 1, 4, im->f) == 4 && !memcmp(magic, IMPORT_MAGIC, 4);
+  if (!im->binary) {
+    rewind(im->f);
+  } else if (!getLittle(im->f, 4, &count) || count > NO_PARK) {
+    importError(m, im);
+    reject(m, ERR_INVALID_FORMAT);
+    return 0;
+  } else {
+    im->names = calloc(count, sizeof(char *));
+    im->parks = malloc(sizeof(Park *) * count);
+    for (; im->parkCount < (int)count; im->parkCount++) {
+      if (!getLittle(im->f, 2, &length) || length >= BUF_SIZE) {
+        importError(m, im);
+        reject(m, ERR_INVALID_FORMAT);
+        return 0;
+      }
+      im->names[im->parkCount] = malloc(length + 1);
+      if (fread(im->names[im->parkCount], 1, length, im->f) != length) {
+        im->parkCount++;
+        importError(m, im);
+        reject(m, ERR_INVALID_FORMAT);
+        return 0;
+      }
+      im->names[im->parkCount][length] = '\0';
+      im->parks[im->parkCount] = getPark(m, im->names[im->parkCount]);
+    }
+  }
+  im->start = ftell(im->f);
+  return 1;
+}
+
+/**
+ * @brief Goes back to the first row of an import file.
+ *
+ * @param im A pointer to the importer.
+ */
+static void importRewind(Importer *im) {
+  fseek(im->f, im->start, SEEK_SET);
+  im->line = 0;
+}
+
+/**
+ * @brief Closes an import file.
+ *
+ * @param im A pointer to the importer.
+ */
+static void importClose(Importer *im) {
+  if (im->f) {
+    fclose(im->f);
+  }
+  for (int i = 0; i < im->parkCount; i++) {
+    free(im->names[i]);
+  }
+  free(im->names);
+  free(im->parks);
+}
+
+/**
+ * @brief Reads a number of up to 9 digits.
+ *
+ * @param s A pointer to the text, which is moved past the number.
+ * @param value A pointer to where the number is stored.
+ * @return Returns 1 if a number was read, or 0 if there are no digits.
+ */
+static int readNumber(char **s, int *value) {
+  int digits = 0;
+  *value = 0;
+  while (**s >= '0' && **s <= '9' && digits < 9) {
+    *value = *value * 10 + (*(*s)++ - '0');
+    digits++;
+  }
+  return digits > 0;
+}
+
+/**
+ * @brief Reads a date and time in the format dd-mm-yyyy hh:mm.
+ *
+ * @param s A pointer to the text, which is moved past the date and time.
+ * @param stamp A pointer to where the date and time are stored, or NO_STAMP
+ * if they are not valid.
+ * @return Returns 1 if the text has the right format, or 0 if it does not.
+ */
+static int readStamp(char **s, Stamp *stamp) {
+  int day, month, year, hours, minutes, date;
+  if (!readNumber(s, &day) || *(*s)++ != '-' || !readNumber(s, &month) ||
+      *(*s)++ != '-' || !readNumber(s, &year) || *(*s)++ != ' ' ||
+      !readNumber(s, &hours) || *(*s)++ != ':' || !readNumber(s, &minutes)) {
+    return 0;
+  }
+  date = dateFromParts(day, month, year);
+  if (date < 0 || hours > 23 || minutes > 59) {
+    *stamp = NO_STAMP;
+  } else {
+    *stamp = STAMP(date, hours * 60 + minutes);
+  }
+  return 1;
+}
+
+/**
+ * @brief Parses a line of a text import file.
+ *
+ * The park name may be quoted, in which case it may contain commas. The exit
+ * may be empty, for vehicles that are still inside.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s The line, which is modified.
+ * @param row A pointer to where the row is stored.
+ * @return Returns 1 if the line has the right format, or 0 if it does not.
+ */
+static int parseLine(Memory *m, char *s, Row *row) {
+  char *end;
+  int length;
+  if (*s == '"') {
+    row->name = ++s;
+    if (!(end = strchr(s, '"')) || end[1] != ',') {
+      return 0;
+    }
+    *end++ = '\0';
+  } else if (!(end = strchr(s, ','))) {
+    return 0;
+  } else {
+    row->name = s;
+  }
+  *end = '\0';
+  s = end + 1;
+  if (!(end = strchr(s, ','))) {
+    return 0;
+  }
+  length = end - s < 8 ? end - s : 8;
+  memset(row->plates, '\0', sizeof(row->plates));
+  memcpy(row->plates, s, length);
+  row->plate = end - s == 8 ? encodePlate(row->plates) : NO_PLATE;
+  s = end + 1;
+  if (!readStamp(&s, &row->entry) || *s++ != ',') {
+    return 0;
+  }
+  row->exit = NO_STAMP;
+  if (*s != '\n' && *s != '\r' && *s != '\0') {
+    if (!readStamp(&s, &row->exit)) {
+      return 0;
+    } else if (row->exit == NO_STAMP) {
+      row->entry = NO_STAMP;  // an invalid exit makes the row's dates invalid
+    }
+  }
+  if (*s == '\r') {
+    s++;
+  }
+  row->park = getPark(m, row->name);
+  return *s == '\n' || *s == '\0';
+}
+
+/**
+ * @brief Reads the next row of an import file.
+ *
+ * Empty lines of text files are skipped.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param im A pointer to the importer.
+ * @param row A pointer to where the row is stored.
+ * @return Returns 1 if a row was read, 0 at the end of the file, or -1 after
+ * printing an error if the row has the wrong format.
+ */
+static int importRead(Memory *m, Importer *im, Row *row) {
+  uint32_t plate, park, flags, entry, exit;
+  if (im->binary) {
+    if (!getLittle(im->f, 4, &plate) || !getLittle(im->f, 2, &park) ||
+        !getLittle(im->f, 2, &flags) || !getLittle(im->f, 4, &entry) ||
+        !getLittle(im->f, 4, &exit)) {
+      return 0;
+    }
+    im->line++;
+    if (park >= (uint32_t)im->parkCount || flags != 0) {
+      importError(m, im);
+      reject(m, ERR_INVALID_FORMAT);
+      return -1;
+    }
+    row->name = im->names[park];
+    row->park = im->parks[park];
+    decodePlate(plate, row->plates);
+    row->plate = checkPlateCode(plate) ? plate : NO_PLATE;
+    row->entry = entry;
+    row->exit = exit;
+    if (entry > LAST_STAMP || exit > LAST_STAMP) {
+      row->entry = NO_STAMP;
+    }
+    return 1;
+  }
+  do {
+    if (!fgets(im->buffer, sizeof(im->buffer), im->f)) {
+      return 0;
+    }
+    im->line++;
+  } while (im->buffer[0] == '\n' ||
+           (im->buffer[0] == '\r' && im->buffer[1] == '\n'));
+  if ((!strchr(im->buffer, '\n') && !feof(im->f)) ||
+      !parseLine(m, im->buffer, row)) {
+    importError(m, im);
+    reject(m, ERR_INVALID_FORMAT);
+    return -1;
+  }
+  return 1;
+}
+
+/**
+ * @brief Compares two departures.
+ *
+ * @param a A pointer to the first departure.
+ * @param b A pointer to the second departure.
+ * @return Returns 1 if the first departure happens before the second.
+ */
+static int departsBefore(Departure *a, Departure *b) {
+  return a->exit < b->exit || (a->exit == b->exit && a->seq < b->seq);
+}
+
+/**
+ * @brief Adds a departure to the queue of a park.
+ *
+ * @param q A pointer to the queue.
+ * @param d The departure.
+ */
+static void departuresPush(Departures *q, Departure d) {
+  int i = q->size++;
+  if (q->size > q->capacity) {
+    q->capacity = q->capacity ? q->capacity * 2 : 16;
+    q->heap = realloc(q->heap, sizeof(Departure) * q->capacity);
+  }
+  while (i > 0 && departsBefore(&d, &q->heap[(i - 1) / 2])) {
+    q->heap[i] = q->heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  q->heap[i] = d;
+}
+
+/**
+ * @brief Removes the earliest departure from the queue of a park.
+ *
+ * @param q A pointer to the queue, which must not be empty.
+ * @return Returns the earliest departure.
+ */
+static Departure departuresPop(Departures *q) {
+  Departure first = q->heap[0], last = q->heap[--q->size];
+  int i = 0, child;
+  while ((child = 2 * i + 1) < q->size) {
+    if (child + 1 < q->size &&
+        departsBefore(&q->heap[child + 1], &q->heap[child])) {
+      child++;
+    }
+    if (!departsBefore(&q->heap[child], &last)) {
+      break;
+    }
+    q->heap[i] = q->heap[child];
+    i = child;
+  }
+  q->heap[i] = last;
+  return first;
+}
+
+/**
+ * @brief Finds the slot of a vehicle in the table of visits.
+ *
+ * @param v A pointer to the table of visits.
+ * @param plate The encoded license plate.
+ * @return Returns the slot of the vehicle, or the empty slot where it goes.
+ */
+static long visitsFind(Visits *v, Plate plate) {
+  long i = (plate * 2654435769UL >> 7) % v->size;
+  while (v->plates[i] != NO_PLATE && v->plates[i] != plate) {
+    i = (i + 1) % v->size;
+  }
+  return i;
+}
+
+/**
+ * @brief Initializes an empty table of visits.
+ *
+ * @param v A pointer to the table of visits.
+ * @param size The number of slots.
+ */
+static void visitsInit(Visits *v, long size) {
+  v->plates = malloc(sizeof(Plate) * size);
+  v->exits = malloc(sizeof(Stamp) * size);
+  memset(v->plates, 0xFF, sizeof(Plate) * size);
+  v->size = size;
+  v->count = 0;
+}
+
+/**
+ * @brief Sets the last exit of a vehicle in the table of visits.
+ *
+ * The table grows before it gets more than half full.
+ *
+ * @param v A pointer to the table of visits.
+ * @param plate The encoded license plate.
+ * @param exit The exit of the vehicle, or NO_STAMP if it stays inside.
+ */
+static void visitsSet(Visits *v, Plate plate, Stamp exit) {
+  long i;
+  if ((v->count + 1) * 2 > v->size) {
+    Visits old = *v;
+    visitsInit(v, old.size * 2 + 1);
+    for (long j = 0; j < old.size; j++) {
+      if (old.plates[j] != NO_PLATE) {
+        i = visitsFind(v, old.plates[j]);
+        v->plates[i] = old.plates[j];
+        v->exits[i] = old.exits[j];
+        v->count++;
+      }
+    }
+    free(old.plates);
+    free(old.exits);
+  }
+  i = visitsFind(v, plate);
+  if (v->plates[i] == NO_PLATE) {
+    v->plates[i] = plate;
+    v->count++;
+  }
+  v->exits[i] = exit;
+}
+
+/**
+ * @brief Checks whether the vehicle of a row is inside a park at its entry.
+ *
+ * Vehicles that appear earlier in the file are checked against their last
+ * exit in the file, and the others against their last record in the system.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param v A pointer to the table of visits.
+ * @param row A pointer to the row.
+ * @return Returns 1 if the vehicle is inside a park, or 0 if it is not.
+ */
+static int vehicleInside(Memory *m, Visits *v, Row *row) {
+  long i = visitsFind(v, row->plate);
+  Record *r;
+  if (v->plates[i] != NO_PLATE) {
+    return v->exits[i] == NO_STAMP || v->exits[i] > row->entry;
+  }
+  r = getLastRecord(m->cars, row->plate);
+  return r && r->exit == NO_STAMP;
+}
+
+/**
+ * @brief Checks a row against the system and the rows before it.
+ *
+ * The checks are those of commands 'e' and 's': the park must exist and have
+ * a free spot, the license plate must be valid, the vehicle must not be inside
+ * any park, the entry must not be before the current date nor the previous
+ * row, and the exit must not be before the entry.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param im A pointer to the importer.
+ * @param row A pointer to the row.
+ * @param visits A pointer to the last exit of each vehicle in the file.
+ * @param queues The pending departures of each park, by park index.
+ * @param last A pointer to the entry of the previous row.
+ * @return Returns 1 if the row is valid, or 0 after printing an error.
+ */
+static int importCheck(Memory *m, Importer *im, Row *row, Visits *visits,
+                       Departures *queues, Stamp *last) {
+  Departures *q = row->park ? &queues[row->park->index] : NULL;
+  if (q) {
+    while (q->size > 0 && q->heap[0].exit <= row->entry) {
+      departuresPop(q);
+    }
+  }
+  if (!row->park) {
+    importError(m, im);
+    reject(m, ERR_PARK_NOT_FOUND(row->name));
+  } else if (row->plate == NO_PLATE) {
+    importError(m, im);
+    reject(m, ERR_INVALID_LICENSE(row->plates));
+  } else if (row->entry == NO_STAMP || row->entry < *last ||
+             row->entry < m->now ||
+             (row->exit != NO_STAMP && row->exit < row->entry)) {
+    importError(m, im);
+    reject(m, ERR_INVALID_DATE);
+  } else if (vehicleInside(m, visits, row)) {
+    importError(m, im);
+    reject(m, ERR_INVALID_ENTRY(row->plates));
+  } else if (row->park->occupancy + q->size >= row->park->capacity) {
+    importError(m, im);
+    reject(m, ERR_FULL_PARK(row->name));
+  } else {
+    Departure d = {row->exit != NO_STAMP ? row->exit : NEVER, im->line, NULL};
+    departuresPush(q, d);
+    visitsSet(visits, row->plate, row->exit);
+    *last = row->entry;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Applies the exit of a vehicle that was imported.
+ *
+ * This does the work of command 's', without printing.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park the vehicle leaves.
+ * @param r A pointer to the record of the stay.
+ */
+static void importExit(Memory *m, Park *p, Record *r) {
+  Cents paid = calculatePrice(p, r);
+  p->occupancy--;
+  historyAdd(p->history, r->exit, p->occupancy);
+  statsExit(p->stats, r, p->occupancy);
+  listAddRecord(&m->nodes, p->records, r);
+  revenueAdd(p->revenue, STAMP_DAY(r->exit), paid);
+  rankExit(m, p, r, paid);
+}
+
+/**
+ * @brief Applies the pending exits of a park up to a given minute.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park.
+ * @param q A pointer to the pending departures of the park.
+ * @param until The last minute whose exits are applied.
+ */
+static void importDepart(Memory *m, Park *p, Departures *q, Stamp until) {
+  while (q->size > 0 && q->heap[0].exit <= until) {
+    importExit(m, p, departuresPop(q).r);
+  }
+}
+
+/**
+ * @brief Writes a number as little-endian bytes.
+ *
+ * @param f The stream.
+ * @param value The number.
+ * @param bytes The number of bytes.
+ */
+static void putLittle(FILE *f, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    fputc(value >> (8 * i) & 0xFF, f);
+  }
+}
+
+/**
+ * @brief Writes the header of the binary import file of the rows imported,
+ * with the names of the parks by index, empty for free indexes.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+static void importLogParks(Memory *m) {
+  fwrite(IMPORT_MAGIC, 1, 4, m->imported);
+  putLittle(m->imported, MAX_PARKS, 4);
+  for (int i = 0; i < MAX_PARKS; i++) {
+    char *name = m->parkTable[i] ? m->parkTable[i]->name : "";
+    putLittle(m->imported, strlen(name), 2);
+    fwrite(name, 1, strlen(name), m->imported);
+  }
+}
+
+/**
+ * @brief Writes an imported record as a row of a binary import file.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param r A pointer to the record.
+ */
+static void importLogRow(Memory *m, Record *r) {
+  putLittle(m->imported, r->plate, 4);
+  putLittle(m->imported, r->park, 2);
+  putLittle(m->imported, 0, 2);
+  putLittle(m->imported, r->entry, 4);
+  putLittle(m->imported, r->exit, 4);
+}
+
+/**
+ * @brief Builds the records of every row of a validated import file.
+ *
+ * The stays of the vehicles still inside get their timers, if overstays are
+ * detected, and the clock is moved to the last entry or exit of the file.
+ * The records are also written to `imported`, if it is set.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param im A pointer to the importer, at the first row.
+ * @param rows The number of rows in the file.
+ * @param vehicles The number of distinct vehicles in the file.
+ * @param queues The pending departures of each park, by park index, empty.
+ */
+static void importBuild(Memory *m, Importer *im, long rows, long vehicles,
+                        Departures *queues) {
+  Row row;
+  Stamp now = m->now;
+  slabReserve(&m->records, rows);
+  hashReserve(m->cars, vehicles);
+  if (m->imported) {
+    importLogParks(m);
+  }
+  while (importRead(m, im, &row) > 0) {
+    Park *p = row.park;
+    Record *r = slabAlloc(&m->records);
+    r->plate = row.plate;
+    r->park = p->index;
+    r->flags = 0;
+    r->entry = row.entry;
+    r->exit = row.exit;
+    importDepart(m, p, &queues[p->index], r->entry);
+    p->occupancy++;
+    historyAdd(p->history, r->entry, p->occupancy);
+    statsEnter(p->stats, r->entry, p->occupancy);
+    addRecord(m, r);
+    if (m->imported) {
+      importLogRow(m, r);
+    }
+    if (r->exit != NO_STAMP) {
+      Departure d = {r->exit, im->line, r};
+      departuresPush(&queues[p->index], d);
+      now = r->exit > now ? r->exit : now;
+    } else if (m->wheel) {
+      wheelArm(m, getHashNode(m->cars, r->plate), r);
+    }
+    now = r->entry > now ? r->entry : now;
+  }
+  for (Node *n = m->parks->head; n; n = n->next) {
+    importDepart(m, n->item.park, &queues[n->item.park->index], NEVER);
+  }
+  updateMemoryTime(m, now);
+  billsClose(m);
+}
+
+/**
+ * @brief Bulk imports the records of an import file.
+ *
+ * The file is validated first, so either every row is imported or none is,
+ * and the first invalid row is reported with its line number. On success, the
+ * number of records imported is printed. The file is closed.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param f The file, or NULL if it could not be opened.
+ * @param path The path of the file, for the messages.
+ */
+static void importFile(Memory *m, FILE *f, char *path) {
+  Importer *im = malloc(sizeof(Importer));
+  Departures queues[MAX_PARKS];
+  Visits visits;
+  Stamp last = NO_STAMP;
+  Row row;
+  long rows = 0;
+  int status = 0;
+  memset(queues, 0, sizeof(queues));
+  visitsInit(&visits, HASH_SIZE);
+  if (importOpen(m, im, f, path)) {
+    while ((status = importRead(m, im, &row)) > 0 &&
+           importCheck(m, im, &row, &visits, queues, &last)) {
+      rows++;
+    }
+    if (status == 0) {
+      for (int i = 0; i < MAX_PARKS; i++) {
+        queues[i].size = 0;
+      }
+      importRewind(im);
+      importBuild(m, im, rows, visits.count, queues);
+      if (m->output == OUTPUT_ALL) {
+        fprintf(m->out, "%s: %ld records imported.\n", path, rows);
+      }
+    }
+  }
+  for (int i = 0; i < MAX_PARKS; i++) {
+    free(queues[i].heap);
+  }
+  free(visits.plates);
+  free(visits.exits);
+  importClose(im);
+  free(im);
+}
+
+/**
+ * @brief Processes command 'i', bulk importing records from a file.
+ *
+ * @param m Pointer to the Memory structure, which contains the list of parks
+ * and records.
+ * @param buffer Buffer containing the path of the file.
+ * @return void
+ */
+void processCommand_i(Memory *m, char *buffer) {
+  char path[BUF_SIZE] = "";
+  if (strchr(buffer, '\"')) {
+    sscanf(buffer, " \"%[^\"]\"", path);
+  } else {
+    sscanf(buffer, "%s", path);
+  }
+  importFile(m, fopen(path, "rb"), path);
+}
+
+/**
+ * @brief Imports the rows written to `imported` by an import into another
+ * system, see `importBuild`.
+ *
+ * @param m A pointer to the Memory structure, as the one that imported the
+ * rows was before the import.
+ * @param rows The rows, as a binary import file.
+ * @param size The number of bytes of `rows`.
+ */
+void importRows(Memory *m, char *rows, size_t size) {
+  importFile(m, fmemopen(rows, size, "rb"), "-");
+}
@@ -0,0 +1,380 @@
+/**
+ * @file library.c
+ * @brief Source file for the library interface of the system.
+ *
+ * This file contains the implementation of the calls declared in park.h. They
+ * are built on the same validation and changes as the text commands, which
+ * print their results from what these calls return, but never print and
+ * take parks by id instead of by name. A ParkSystem is the Memory of the
+ * program, with errors only counted.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+/**
+ * @brief Creates an empty system.
+ *
+ * @return Returns a pointer to the new system, to be freed with `parkClose`.
+ */
+ParkSystem *parkOpen(void) {
+  Memory *m = malloc(sizeof(Memory));
+  initializeSystem(m);
+  m->output = OUTPUT_NONE;
+  return m;
+}
+
+/**
+ * @brief Sets how many records each vehicle keeps, as options -k and -d.
+ *
+ * The totals billed are not changed by the records dropped, but the exits
+ * listed by `parkBillsDate` and the records listed by `parkVehicle` are only
+ * those kept.
+ *
+ * @param s A pointer to the system.
+ * @param records The number of records kept by each vehicle, or 0 for all.
+ * @param days The number of days before the current one whose records are
+ * kept by each vehicle, or 0 for all.
+ */
+void parkRetain(ParkSystem *s, int records, int days) {
+  s->keepRecords = records;
+  s->keepDays = days;
+}
+
+/**
+ * @brief Frees a system and all its parks and records.
+ *
+ * @param s A pointer to the system.
+ */
+void parkClose(ParkSystem *s) { cleanUp(s); }
+
+/**
+ * @brief Encodes a license plate.
+ *
+ * The text is checked to have the length and dashes of a license plate
+ * before its pairs are read, so any string may be given.
+ *
+ * @param text The license plate, as in "AA-00-AA".
+ * @return Returns the encoded license plate, or NO_PLATE if it is not valid.
+ */
+Plate parkPlate(const char *text) {
+  if (strlen(text) != 8 || text[2] != '-' || text[5] != '-') {
+    return NO_PLATE;
+  }
+  return encodePlate((char *)text);
+}
+
+/**
+ * @brief Converts a date to a day.
+ *
+ * @param day The day of the month.
+ * @param month The month, January is 1.
+ * @param year The year.
+ * @return Returns the day, or -1 if the date is not valid.
+ */
+int parkDay(int day, int month, int year) {
+  return dateFromParts(day, month, year);
+}
+
+/**
+ * @brief Converts a day and a time to a Stamp.
+ *
+ * @param day The day, from `parkDay`.
+ * @param hour The hour.
+ * @param minute The minute.
+ * @return Returns the Stamp, or NO_STAMP if the time is not valid.
+ */
+Stamp parkStamp(int day, int hour, int minute) {
+  if (day < 0 || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+    return NO_STAMP;
+  }
+  return STAMP(day, hour * 60 + minute);
+}
+
+/**
+ * @brief Finds a park by name.
+ *
+ * @param s A pointer to the system.
+ * @param name The name of the park.
+ * @return Returns the id of the park, or -1 if there is no such park.
+ */
+int parkFind(ParkSystem *s, const char *name) {
+  Park *p = getPark(s, (char *)name);
+  return p ? p->id : -1;
+}
+
+/**
+ * @brief Adds a park, as command 'p'.
+ *
+ * @param s A pointer to the system.
+ * @param name The name of the park.
+ * @param capacity The number of spots of the park.
+ * @param first The price of each 15 minutes in the first hour.
+ * @param next The price of each 15 minutes after the first hour.
+ * @param daily The largest price of each 24 hours.
+ * @param id A pointer to where the id of the new park is stored.
+ * @return Returns ST_OK, ST_PARK_EXISTS, ST_INVALID_CAPACITY, ST_INVALID_COST
+ * or ST_TOO_MANY_PARKS.
+ */
+int parkAdd(ParkSystem *s, const char *name, int capacity, Cents first,
+            Cents next, Cents daily, int *id) {
+  Park *p;
+  int status = addPark(s, (char *)name, capacity, first, next, daily, &p);
+  if (status == ST_OK) {
+    *id = p->id;
+  }
+  return status;
+}
+
+/**
+ * @brief Removes a park and all its records, as command 'r'.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @return Returns ST_OK or ST_PARK_NOT_FOUND.
+ */
+int parkRemove(ParkSystem *s, int park) {
+  if (!getParkById(s, park)) {
+    return ST_PARK_NOT_FOUND;
+  }
+  removePark(s, park);
+  return ST_OK;
+}
+
+/**
+ * @brief Enters a vehicle in a park, as command 'e'.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @param plate The encoded license plate.
+ * @param now The date and time of the entry.
+ * @param spots A pointer to where the free spots left in the park are stored.
+ * @return Returns ST_OK, ST_PARK_NOT_FOUND, ST_FULL_PARK, ST_INVALID_LICENSE,
+ * ST_INVALID_ENTRY or ST_INVALID_DATE.
+ */
+int parkEnter(ParkSystem *s, int park, Plate plate, Stamp now, int *spots) {
+  return vehicleEnter(s, getParkById(s, park), plate, now, spots);
+}
+
+/**
+ * @brief Exits a vehicle from a park, as command 's'.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @param plate The encoded license plate.
+ * @param now The date and time of the exit.
+ * @param payment A pointer to where the closed record and the amount paid
+ * are stored.
+ * @return Returns ST_OK, ST_PARK_NOT_FOUND, ST_INVALID_LICENSE,
+ * ST_INVALID_EXIT or ST_INVALID_DATE.
+ */
+int parkExit(ParkSystem *s, int park, Plate plate, Stamp now,
+             ParkPayment *payment) {
+  Park *p = getParkById(s, park);
+  Record *r;
+  int status = vehicleExit(s, p, plate, now, &r);
+  if (status == ST_OK) {
+    payment->plate = plate;
+    payment->park = park;
+    payment->entry = r->entry;
+    payment->exit = r->exit;
+    payment->paid = calculatePrice(p, r);
+  }
+  return status;
+}
+
+/**
+ * @brief Lists the records of a vehicle, as command 'v'.
+ *
+ * The records are sorted by the name of the park, and by entry within a park.
+ *
+ * @param s A pointer to the system.
+ * @param plate The encoded license plate.
+ * @param visits A pointer to where the array of records is stored.
+ * @param count A pointer to where the number of records is stored.
+ * @return Returns ST_OK, ST_INVALID_LICENSE or ST_NO_ENTRIES.
+ */
+int parkVehicle(ParkSystem *s, Plate plate, ParkVisit **visits, int *count) {
+  return parkVehicleDates(s, plate, 0, INT_MAX, visits, count);
+}
+
+/**
+ * @brief Lists the records of a vehicle between two days, as command 'v'
+ * with dates.
+ *
+ * The records listed are those of stays with a day in the range, both
+ * included: an entry on or before `to` and an exit on or after `from`, or no
+ * exit. They are found with `seekRecords`, so the cost grows with the number
+ * of records listed, not with the history of the vehicle. They are sorted by
+ * the name of the park, and by entry within a park.
+ *
+ * @param s A pointer to the system.
+ * @param plate The encoded license plate.
+ * @param from The first day.
+ * @param to The last day.
+ * @param visits A pointer to where the array of records is stored.
+ * @param count A pointer to where the number of records, maybe 0, is stored.
+ * @return Returns ST_OK, ST_INVALID_LICENSE or ST_NO_ENTRIES if the vehicle
+ * has no records at all.
+ */
+int parkVehicleDates(ParkSystem *s, Plate plate, int from, int to,
+                     ParkVisit **visits, int *count) {
+  HashNode *n;
+  Node *first, *last;
+  Node **array;
+  int size = 0;
+  if (!checkPlateCode(plate)) {
+    return ST_INVALID_LICENSE;
+  }
+  if (!(n = getHashNode(s->cars, plate)) || n->records->size == 0) {
+    return ST_NO_ENTRIES;
+  }
+  first = seekRecords(n, from);
+  for (last = first; last && STAMP_DAY(last->item.record->entry) <= to;
+       last = last->next) {
+    size++;
+  }
+  array = sortRecords(s, first, size);
+  *visits = malloc((size > 0 ? size : 1) * sizeof(ParkVisit));
+  *count = size;
+  for (int i = 0; i < size; i++) {
+    Record *r = array[i]->item.record;
+    (*visits)[i].park = s->parkTable[r->park]->id;
+    (*visits)[i].entry = r->entry;
+    (*visits)[i].exit = r->exit;
+  }
+  free(array);
+  return ST_OK;
+}
+
+/**
+ * @brief Lists the total billed by a park on each day with exits, as command
+ * 'f' with no dates.
+ *
+ * The totals are read from the revenue index of the park, so they count the
+ * records dropped by their vehicles too.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @param days A pointer to where the array of days is stored.
+ * @param count A pointer to where the number of days is stored.
+ * @return Returns ST_OK or ST_PARK_NOT_FOUND.
+ */
+int parkBills(ParkSystem *s, int park, ParkDay **days, int *count) {
+  Park *p = getParkById(s, park);
+  Revenue *r;
+  if (!p) {
+    return ST_PARK_NOT_FOUND;
+  }
+  r = p->revenue;
+  *days = malloc((r->size > 0 ? r->size : 1) * sizeof(ParkDay));
+  *count = r->size;
+  for (int i = 0; i < r->size; i++) {
+    (*days)[i].day = r->days[i];
+    (*days)[i].total = r->prefix[i] - (i > 0 ? r->prefix[i - 1] : 0);
+  }
+  return ST_OK;
+}
+
+/**
+ * @brief Lists the exits from a park on a day, as command 'f' with one date.
+ *
+ * Only the records kept by their vehicles are listed, see `parkRetain`.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @param day The day.
+ * @param payments A pointer to where the array of exits is stored.
+ * @param count A pointer to where the number of exits is stored.
+ * @return Returns ST_OK, ST_PARK_NOT_FOUND or ST_INVALID_DATE.
+ */
+int parkBillsDate(ParkSystem *s, int park, int day, ParkPayment **payments,
+                  int *count) {
+  Park *p = getParkById(s, park);
+  int i = 0;
+  if (!p) {
+    return ST_PARK_NOT_FOUND;
+  } else if (day > STAMP_DAY(s->now)) {
+    return ST_INVALID_DATE;
+  }
+  *count = 0;
+  for (Node *n = p->records->head; n; n = n->next) {
+    *count += day == STAMP_DAY(n->item.record->exit) &&
+              !(n->item.record->flags & RECORD_EVICTED);
+  }
+  *payments = malloc((*count > 0 ? *count : 1) * sizeof(ParkPayment));
+  for (Node *n = p->records->head; n; n = n->next) {
+    Record *r = n->item.record;
+    if (day == STAMP_DAY(r->exit) && !(r->flags & RECORD_EVICTED)) {
+      ParkPayment payment = {r->plate, park, r->entry, r->exit,
+                             calculatePrice(p, r)};
+      (*payments)[i++] = payment;
+    }
+  }
+  return ST_OK;
+}
+
+/**
+ * @brief Computes the total billed by a park between two days, both
+ * included, as command 'f' with two dates.
+ *
+ * @param s A pointer to the system.
+ * @param park The id of the park.
+ * @param from The first day.
+ * @param to The last day.
+ * @param total A pointer to where the total is stored.
+ * @return Returns ST_OK, ST_PARK_NOT_FOUND or ST_INVALID_DATE.
+ */
+int parkBillsRange(ParkSystem *s, int park, int from, int to, Cents *total) {
+  Park *p = getParkById(s, park);
+  if (!p) {
+    return ST_PARK_NOT_FOUND;
+  } else if (from > STAMP_DAY(s->now) || to < from) {
+    return ST_INVALID_DATE;
+  }
+  *total = revenueRange(p->revenue, from, to);
+  return ST_OK;
+}
+
+/**
+ * @brief Counts the errors printed so far.
+ *
+ * @param s A pointer to the system.
+ * @return Returns the number of errors printed.
+ */
+static long rejections(ParkSystem *s) {
+  long total = 0;
+  for (int i = 0; i < s->summary.reasonCount; i++) {
+    total += s->summary.rejections[i];
+  }
+  return total;
+}
+
+/**
+ * @brief Runs a text command, such as 'x' to export the records, for what
+ * the other calls do not do. Its output is discarded.
+ *
+ * @param s A pointer to the system.
+ * @param command The command, as a line of the text program without the
+ * newline, of at most BUF_SIZE characters.
+ * @return Returns ST_OK, or ST_REJECTED if the command printed an error or is
+ * empty or too long.
+ */
+int parkCommand(ParkSystem *s, const char *command) {
+  char buffer[BUF_SIZE + 1];
+  size_t length = strlen(command);
+  int output = s->output;
+  long before = rejections(s);
+  if (length == 0 || length > BUF_SIZE) {
+    return ST_REJECTED;
+  }
+  memcpy(buffer, command, length + 1);
+  s->output = OUTPUT_NONE;
+  execute(s, buffer[0], buffer + 1);
+  s->output = output;
+  return rejections(s) > before ? ST_REJECTED : ST_OK;
+}
@@ -7,16 +7,18 @@
  * @brief Frees the memory allocated for a list of nodes.
  *
  * This function frees the memory allocated for a list of nodes. It iterates
- * over the list and frees each node. After all nodes have been freed, it frees
- * the list itself.
+ * over the list and returns each node to the slab of the nodes. After all
+ * nodes have been returned, it frees the list itself.
  *
+ * @param s A pointer to the slab of the nodes, or NULL if the whole slab is
+ * about to be destroyed, so the nodes are left in it.
  * @param l A pointer to the list to be freed.
  */
-static void freeNodes(List *l) {
-  Node *n = l->head;
+static void freeNodes(Slab *s, List *l) {
+  Node *n = s ? l->head : NULL;
   while (n) {
     Node *next = n->next;
-    free(n);
+    slabFree(s, n);
     n = next;
   }
   free(l);
@@ -25,14 +27,20 @@ static void freeNodes(List *l) {
  * @brief Frees the memory allocated for a Park structure.
  *
  * This function frees the memory allocated for a Park structure. It frees the
- * memory for the name of the park, the list of records associated with the
- * park, and the Park structure itself.
+ * memory for the list of records associated with the
+ * park, its revenue index, billing text, occupancy history and statistics,
+ * its lock and the Park structure itself.
  *
+ * @param nodes A pointer to the slab of the nodes, or NULL, see `freeNodes`.
  * @param p A pointer to the Park structure to be freed.
  */
-void freePark(Park *p) {
-  if (p->name) free(p->name);
-  if (p->records) freeNodes(p->records);
+void freePark(Slab *nodes, Park *p) {
+  if (p->records) freeNodes(nodes, p->records);
+  if (p->revenue) freeRevenue(p->revenue);
+  if (p->bills) freeBills(p->bills);
+  pthread_mutex_destroy(&p->lock);
+  if (p->history) freeHistory(p->history);
+  if (p->stats) freeStats(p->stats);
   free(p);
 }
 
@@ -41,7 +49,8 @@ void freePark(Park *p) {
  *
  * This function frees the memory allocated for a list. It iterates over
  * the list and frees each node. After all nodes have been freed, it frees
- * the list itself.
+ * the list itself. The records of the parks are left in the slab of the
+ * nodes, which is destroyed as a whole.
  *
  * @param l A pointer to the list to be freed.
  */
@@ -49,27 +58,7 @@ static void listFree(List *l) {
   Node *n = l->head;
   while (n) {
     Node *next = n->next;
-    freePark(n->item.park);
-    free(n);
-    n = next;
-  }
-  free(l);
-}
-
-/**
- * @brief Frees the memory allocated for a list of records.
- *
- * This function frees the memory allocated for a list of records. It iterates
- * over the list and frees each node and the record in the node. After all
- * nodes and records have been freed, it frees the list itself.
- *
- * @param l A pointer to the list to be freed.
- */
-static void listRecordsFree(List *l) {
-  Node *n = l->head;
-  while (n) {
-    Node *next = n->next;
-    free(n->item.record);
+    freePark(NULL, n->item.park);
     free(n);
     n = next;
   }
@@ -95,22 +84,40 @@ void freeDateSumList(List *l) {
   }
   free(l);
 }
+/**
+ * @brief Frees the per-park totals of a vehicle.
+ *
+ * @param n A pointer to the hash table node of the vehicle.
+ */
+void freeTallies(HashNode *n) {
+  Tally *t = n->parks;
+  while (t) {
+    Tally *next = t->next;
+    free(t);
+    t = next;
+  }
+  n->parks = NULL;
+}
+
 /**
  * @brief Frees the memory allocated for a hash table.
  *
  * This function frees the memory allocated for a hash table. It iterates over
- * the hash table and frees each list of records and each hash table entry.
- * After all entries have been freed, it frees the hash table itself.
+ * the hash table and frees the per-park totals and the marks of each entry.
+ * The entries, their lists of records and the nodes of the lists belong to
+ * slabs, which are freed as a whole. After all entries have been freed, it
+ * frees the hash table itself.
  *
  * @param h A pointer to the hash table to be freed.
  */
 static void freeHastable(HashTable *h) {
-  for (int i = 0; i < HASH_SIZE; i++) {
+  for (int i = 0; i < h->size; i++) {
     if (h->plate[i] != NULL) {
-      listRecordsFree(h->plate[i]->records);
-      free(h->plate[i]);
+      freeTallies(h->plate[i]);
+      free(h->plate[i]->marks);
     }
   }
+  hugeUnmap(h->plate, h->size * sizeof(HashNode *));
   free(h);
 }
 
@@ -118,12 +125,28 @@ static void freeHastable(HashTable *h) {
  * @brief Frees the memory allocated for the system.
  *
  * This function frees the memory allocated for the system. It frees the list
- * of parks, the hash table of cars, and the Memory structure itself.
+ * of parks, the pool of park names, the hash table of cars, the slabs of
+ * records, nodes, vehicles and lists, the locks, the timer wheel and the
+ * Memory structure itself.
  *
  * @param m A pointer to the Memory structure to be freed.
  */
 void cleanUp(Memory *m) {
   listFree(m->parks);
+  free(m->names.chars);
   freeHastable(m->cars);
+  slabDestroy(&m->records);
+  slabDestroy(&m->nodes);
+  slabDestroy(&m->vehicles);
+  slabDestroy(&m->lists);
+  pthread_rwlock_destroy(&m->table);
+  for (int i = 0; i < PLATE_STRIPES; i++) {
+    pthread_mutex_destroy(&m->stripes[i].lock);
+  }
+  free(m->stripes);
+  pthread_mutex_destroy(&m->lock);
+  if (m->wheel) {
+    freeWheel(m->wheel);
+  }
   free(m);
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+/**
+ * @file merge.c
+ * @brief Source file for the merge of many input streams by time.
+ *
+ * This file contains the implementation of the merge of the inputs given
+ * after the options, files or FIFOs, each one the time-ordered commands of a
+ * site, with "-" for stdin. The streams are merged as they are read: only the
+ * next line of each stream is held, in a binary heap ordered by the time of
+ * the line and then by the position of the stream in the arguments, and the
+ * line at the top is executed as if it had been read from stdin.
+ *
+ * The time of commands 'e' and 's' is their date and time. Every other
+ * command, and an 'e' or 's' with no valid date, takes the time of the last
+ * 'e' or 's' of its stream before it, or 0 at its start, so it runs right
+ * after the changes that come before it in its stream. The order of the
+ * lines of each stream is never changed. The command 'q' ends its stream
+ * only, and the merge ends when every stream ends.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+/**
+ * @brief Structure to hold an input stream and its next line.
+ *
+ * @param in The stream.
+ * @param index The position of the stream in the arguments.
+ * @param stamp The time of the next line.
+ * @param command The command of the next line.
+ * @param buffer The arguments of the next line.
+ */
+typedef struct {
+  FILE *in;
+  int index;
+  Stamp stamp;
+  char command;
+  char buffer[BUF_SIZE + 1];
+} Stream;
+
+/**
+ * @brief Finds the time of a line, if it is an entry or an exit.
+ *
+ * @param command The command of the line.
+ * @param buffer The arguments of the line.
+ * @return Returns the date and time of the entry or exit, or NO_STAMP.
+ */
+static Stamp lineStamp(char command, char *buffer) {
+  char name[BUF_SIZE], plates[BUF_SIZE], date[BUF_SIZE], time[BUF_SIZE];
+  int read;
+  if (command != CM_ADD_VEHICLE && command != CM_EXIT_VEHICLE) {
+    return NO_STAMP;
+  }
+  if (strchr(buffer, '\"')) {
+    read = sscanf(buffer, " \"%[^\"]\" %s %s %s", name, plates, date, time);
+  } else {
+    read = sscanf(buffer, "%s %s %s %s", name, plates, date, time);
+  }
+  return read == 4 ? parseStamp(date, time) : NO_STAMP;
+}
+
+/**
+ * @brief Reads the next line of a stream.
+ *
+ * The first character of the line is the command and the rest, up to
+ * BUF_SIZE characters, its arguments.
+ *
+ * @param s A pointer to the stream.
+ * @return Returns 1, or 0 if the stream ended, at its end or with 'q'.
+ */
+static int readStream(Stream *s) {
+  int c = getc_unlocked(s->in), size = 0;
+  Stamp stamp;
+  if (c == EOF || c == CM_EXIT) {
+    return 0;
+  }
+  s->command = c;
+  while (c != '\n' && (c = getc_unlocked(s->in)) != EOF && c != '\n') {
+    if (size < BUF_SIZE) {
+      s->buffer[size++] = c;
+    }
+  }
+  s->buffer[size] = '\0';
+  if ((stamp = lineStamp(s->command, s->buffer)) != NO_STAMP) {
+    s->stamp = stamp;
+  }
+  return 1;
+}
+
+/**
+ * @brief Compares the next lines of two streams.
+ *
+ * @param a A pointer to the first stream.
+ * @param b A pointer to the second stream.
+ * @return Returns 1 if the line of `a` runs first, or 0 otherwise.
+ */
+static int runsFirst(Stream *a, Stream *b) {
+  return a->stamp < b->stamp || (a->stamp == b->stamp && a->index < b->index);
+}
+
+/**
+ * @brief Moves the stream at a position of the heap down to its place.
+ *
+ * @param heap The heap of streams.
+ * @param size The number of streams in the heap.
+ * @param i The position of the stream.
+ */
+static void siftDown(Stream **heap, int size, int i) {
+  while (2 * i + 1 < size) {
+    int child = 2 * i + 1;
+    Stream *t;
+    if (child + 1 < size && runsFirst(heap[child + 1], heap[child])) {
+      child++;
+    }
+    if (!runsFirst(heap[child], heap[i])) {
+      return;
+    }
+    t = heap[i];
+    heap[i] = heap[child];
+    heap[child] = t;
+    i = child;
+  }
+}
+
+/**
+ * @brief Closes the streams opened, all but stdin.
+ *
+ * @param streams The streams.
+ * @param count The number of streams opened.
+ */
+static void closeStreams(Stream *streams, int count) {
+  for (int i = 0; i < count; i++) {
+    if (streams[i].in != stdin) {
+      fclose(streams[i].in);
+    }
+  }
+}
+
+/**
+ * @brief Executes the commands of many input streams, merged by time.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param count The number of inputs.
+ * @param paths The paths of the inputs, "-" for stdin.
+ * @return Returns 1, or 0 after printing the error if an input cannot be
+ * opened.
+ */
+int serveStreams(Memory *m, int count, char *paths[]) {
+  Stream *streams = malloc(sizeof(Stream) * count);
+  Stream **heap = malloc(sizeof(Stream *) * count);
+  int size = 0;
+  for (int i = 0; i < count; i++) {
+    streams[i].in = strcmp(paths[i], "-") ? fopen(paths[i], "r") : stdin;
+    if (!streams[i].in) {
+      perror(paths[i]);
+      closeStreams(streams, i);
+      free(streams);
+      free(heap);
+      return 0;
+    }
+    streams[i].index = i;
+    streams[i].stamp = NO_STAMP;
+  }
+  for (int i = 0; i < count; i++) {
+    if (readStream(&streams[i])) {
+      heap[size++] = &streams[i];
+    }
+  }
+  for (int i = size / 2 - 1; i >= 0; i--) {
+    siftDown(heap, size, i);
+  }
+  while (size > 0) {
+    execute(m, heap[0]->command, heap[0]->buffer);
+    if (!readStream(heap[0])) {
+      heap[0] = heap[--size];
+    }
+    siftDown(heap, size, 0);
+  }
+  closeStreams(streams, count);
+  free(streams);
+  free(heap);
+  return 1;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file names.c
+ * @brief Source file for the park names.
+ *
+ * This file contains the implementation of the pool where the names of the
+ * parks are interned and of the index of the parks by name. Every name is
+ * stored once, one after the other, in a single buffer that is compacted when
+ * a park is removed. The index keeps the parks sorted by name, so each park
+ * knows its rank in lexicographic order, parks are found by name with a binary
+ * search and ordering two parks by name is an integer comparison.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+#define POOL_INITIAL_SIZE 256 /*Initial size of the pool of names*/
+
+/**
+ * @brief Points the name of every park at its place in the pool.
+ *
+ * This function is called whenever the pool is moved or compacted.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+static void poolRelink(Memory *m) {
+  for (int i = 0; i < m->parks->size; i++) {
+    m->byName[i]->name = m->names.chars + m->byName[i]->nameOffset;
+  }
+}
+
+/**
+ * @brief Stores the name of a park in the pool.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park, whose name is replaced by the interned one.
+ */
+static void poolIntern(Memory *m, Park *p) {
+  NamePool *pool = &m->names;
+  int length = strlen(p->name) + 1;
+  if (pool->size + length > pool->capacity) {
+    while (pool->size + length > pool->capacity) {
+      pool->capacity = pool->capacity ? pool->capacity * 2 : POOL_INITIAL_SIZE;
+    }
+    pool->chars = realloc(pool->chars, pool->capacity);
+    poolRelink(m);
+  }
+  memcpy(pool->chars + pool->size, p->name, length);
+  p->nameOffset = pool->size;
+  p->name = pool->chars + pool->size;
+  pool->size += length;
+}
+
+/**
+ * @brief Removes the name of a park from the pool.
+ *
+ * The names after it are moved back, so the pool has no gaps.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park, which must no longer be in the index.
+ */
+static void poolRelease(Memory *m, Park *p) {
+  NamePool *pool = &m->names;
+  int length = strlen(p->name) + 1, end = p->nameOffset + length;
+  memmove(pool->chars + p->nameOffset, pool->chars + end, pool->size - end);
+  pool->size -= length;
+  for (int i = 0; i < m->parks->size; i++) {
+    if (m->byName[i]->nameOffset > p->nameOffset) {
+      m->byName[i]->nameOffset -= length;
+    }
+  }
+  poolRelink(m);
+  p->name = NULL;
+}
+
+/**
+ * @brief Finds the rank a name has, or would have, in the index.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param size The number of parks in the index.
+ * @param name The name to search for.
+ * @return Returns the number of parks whose name comes before the given name.
+ */
+static int nameRank(Memory *m, int size, char *name) {
+  int low = 0, high = size;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (strcmp(m->byName[mid]->name, name) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief Retrieves a park by name.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param name The name of the park to be retrieved.
+ * @return Returns a pointer to the park if found, or NULL if not found.
+ */
+Park *getPark(Memory *m, char *name) {
+  int rank = nameRank(m, m->parks->size, name);
+  if (rank < m->parks->size && strcmp(m->byName[rank]->name, name) == 0) {
+    return m->byName[rank];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Interns the name of a new park and adds it to the index.
+ *
+ * This function must be called before the park is added to the list of
+ * parks. The ranks of the parks after it are incremented.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the new park.
+ */
+void namesAddPark(Memory *m, Park *p) {
+  int size = m->parks->size, rank = nameRank(m, size, p->name);
+  poolIntern(m, p);
+  for (int i = size; i > rank; i--) {
+    m->byName[i] = m->byName[i - 1];
+    m->byName[i]->rank = i;
+  }
+  m->byName[rank] = p;
+  p->rank = rank;
+}
+
+/**
+ * @brief Removes a park from the index and its name from the pool.
+ *
+ * This function must be called after the park is removed from the list of
+ * parks. The ranks of the parks after it are decremented.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park being removed.
+ */
+void namesRemovePark(Memory *m, Park *p) {
+  for (int i = p->rank; i < m->parks->size; i++) {
+    m->byName[i] = m->byName[i + 1];
+    m->byName[i]->rank = i;
+  }
+  poolRelease(m, p);
+}
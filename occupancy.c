@@ -0,0 +1,182 @@
+/**
+ * @file occupancy.c
+ * @brief Source file for the occupancy history of the parks.
+ *
+ * This file contains the implementation of the occupancy history kept by
+ * every park. Each entry or exit appends the new occupancy of the park and
+ * the minute it happened to a time-ordered log, since entries and exits are
+ * always recorded in chronological order. Events on the same minute share an
+ * entry, with the occupancy at the end of the minute and the largest one
+ * during it. The log is searched with a binary
+ * search to get the occupancy at any past minute, and a segment tree over the
+ * occupancies gives the peak occupancy over a range of dates, so both queries
+ * take logarithmic time in the history of the park.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdlib.h>
+
+#include "project.h"
+
+#define HISTORY_INITIAL_SIZE 64 /*Initial number of events in the log*/
+
+/**
+ * @brief Creates a new, empty occupancy history.
+ *
+ * @return Returns a pointer to the newly created occupancy history.
+ */
+History *historyNew() {
+  History *h = malloc(sizeof(History));
+  h->stamps = NULL;
+  h->occupancy = NULL;
+  h->peak = NULL;
+  h->size = 0;
+  h->capacity = 0;
+  return h;
+}
+
+/**
+ * @brief Updates the segment tree with the occupancy of an event.
+ *
+ * The leaves of the tree, starting at `capacity`, hold the largest occupancy
+ * during the minute of each event, and each inner node holds the largest
+ * occupancy of its children.
+ *
+ * @param h A pointer to the occupancy history.
+ * @param i The index of the event in the log.
+ * @param peak The largest occupancy during the minute of the event.
+ */
+static void historySet(History *h, int i, int peak) {
+  i += h->capacity;
+  h->peak[i] = peak;
+  for (i /= 2; i > 0; i /= 2) {
+    h->peak[i] = h->peak[2 * i] > h->peak[2 * i + 1] ? h->peak[2 * i]
+                                                     : h->peak[2 * i + 1];
+  }
+}
+
+/**
+ * @brief Doubles the capacity of the occupancy history.
+ *
+ * The segment tree is rebuilt from its leaves, so appending an event takes
+ * amortized logarithmic time.
+ *
+ * @param h A pointer to the occupancy history.
+ */
+static void historyGrow(History *h) {
+  int capacity = h->capacity ? h->capacity * 2 : HISTORY_INITIAL_SIZE;
+  int *peak = calloc(2 * capacity, sizeof(int));
+  for (int i = 0; i < h->size; i++) {
+    peak[capacity + i] = h->peak[h->capacity + i];
+  }
+  for (int i = capacity - 1; i > 0; i--) {
+    peak[i] = peak[2 * i] > peak[2 * i + 1] ? peak[2 * i] : peak[2 * i + 1];
+  }
+  free(h->peak);
+  h->peak = peak;
+  h->stamps = realloc(h->stamps, sizeof(Stamp) * capacity);
+  h->occupancy = realloc(h->occupancy, sizeof(int) * capacity);
+  h->capacity = capacity;
+}
+
+/**
+ * @brief Records a change in the occupancy of a park.
+ *
+ * If the last event happened on the same minute, its occupancy is replaced,
+ * so the log holds the occupancy at the end of each minute with events, and
+ * its peak is raised if needed, so a peak reached within the minute is kept.
+ *
+ * @param h A pointer to the occupancy history of the park.
+ * @param stamp The date and time of the event.
+ * @param occupancy The occupancy of the park after the event.
+ */
+void historyAdd(History *h, Stamp stamp, int occupancy) {
+  if (h->size > 0 && h->stamps[h->size - 1] == stamp) {
+    h->occupancy[h->size - 1] = occupancy;
+    if (occupancy > h->peak[h->capacity + h->size - 1]) {
+      historySet(h, h->size - 1, occupancy);
+    }
+    return;
+  }
+  if (h->size == h->capacity) {
+    historyGrow(h);
+  }
+  h->stamps[h->size] = stamp;
+  h->occupancy[h->size] = occupancy;
+  historySet(h, h->size++, occupancy);
+}
+
+/**
+ * @brief Finds the number of events up to a given minute.
+ *
+ * @param h A pointer to the occupancy history.
+ * @param stamp The date and time.
+ * @return Returns the number of events that happened on or before the minute.
+ */
+static int historyCount(History *h, Stamp stamp) {
+  int low = 0, high = h->size;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (h->stamps[mid] <= stamp) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief Retrieves the occupancy of a park at a past date and time.
+ *
+ * @param h A pointer to the occupancy history of the park.
+ * @param stamp The date and time.
+ * @return Returns the occupancy of the park at the end of that minute.
+ */
+int historyAt(History *h, Stamp stamp) {
+  int i = historyCount(h, stamp);
+  return i > 0 ? h->occupancy[i - 1] : 0;
+}
+
+/**
+ * @brief Retrieves the peak occupancy of a park between two dates.
+ *
+ * The peak is the largest of the occupancy at the start of the first day and
+ * the peaks of the minutes with events until the end of the last day, which
+ * are read from the segment tree.
+ *
+ * @param h A pointer to the occupancy history of the park.
+ * @param from The first day of the range.
+ * @param to The last day of the range.
+ * @return Returns the peak occupancy of the park in the range.
+ */
+int historyPeak(History *h, int from, int to) {
+  int first = historyCount(h, STAMP(from, 0) - 1);
+  int last = historyCount(h, STAMP(to, MINUTES_PER_DAY - 1));
+  int peak = first > 0 ? h->occupancy[first - 1] : 0;
+  // maximum of the leaves in [first, last)
+  for (first += h->capacity, last += h->capacity; first < last;
+       first /= 2, last /= 2) {
+    if (first & 1) {
+      peak = h->peak[first] > peak ? h->peak[first] : peak;
+      first++;
+    }
+    if (last & 1) {
+      last--;
+      peak = h->peak[last] > peak ? h->peak[last] : peak;
+    }
+  }
+  return peak;
+}
+
+/**
+ * @brief Frees the memory allocated for an occupancy history.
+ *
+ * @param h A pointer to the occupancy history to be freed.
+ */
+void freeHistory(History *h) {
+  free(h->stamps);
+  free(h->occupancy);
+  free(h->peak);
+  free(h);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file park.h
+ * @brief Public header of the Parking Management library.
+ *
+ * This file declares the library built from every source file but project.c,
+ * for programs that manage parks without running the text program. A
+ * ParkSystem holds all the parks and records, and the calls enter and exit
+ * vehicles, add and remove parks and query records and billing, returning
+ * one of the ST_ status codes and filling result structures instead of
+ * printing. Parks are given by id, license plates are encoded with
+ * `parkPlate`, dates are days from `parkDay` and times are Stamps from
+ * `parkStamp`. Lists returned by the queries are allocated by the library
+ * and freed by the caller with `free`. Many threads may call `parkEnter`
+ * and `parkExit` at once, as the gates of the parks would, but no other call
+ * may run while any call runs on the same ParkSystem.
+ *
+ * @author Iuri Campos - 51948
+ */
+#ifndef PARK_H
+#define PARK_H
+#include <stdint.h>
+
+typedef uint32_t Plate; /* license plate, see encodePlate */
+typedef uint32_t Stamp; /* minutes since 01-01-0000 00:00 */
+typedef long Cents;     /* amount of money, in cents */
+
+#define NO_PLATE UINT32_MAX /*Used to mark an invalid license plate*/
+
+/*State of the system, opaque to the programs using the library*/
+typedef struct memory ParkSystem;
+
+/*-------------\
+| STATUS CODES |
+\-------------*/
+
+#define ST_OK 0              /*The command succeeded*/
+#define ST_PARK_NOT_FOUND 1  /*No park with the given id*/
+#define ST_FULL_PARK 2       /*The park is full*/
+#define ST_INVALID_LICENSE 3 /*The license plate is not valid*/
+#define ST_INVALID_ENTRY 4   /*The vehicle is already inside a park*/
+#define ST_INVALID_EXIT 5    /*The vehicle is not inside the park*/
+#define ST_INVALID_DATE 6    /*The date is not valid or is in the past*/
+#define ST_NO_ENTRIES 7      /*The vehicle has no records*/
+#define ST_REJECTED 8        /*A text command was rejected*/
+#define ST_INVALID_FRAME 9   /*The frame has an unknown operation*/
+#define ST_PARK_EXISTS 10    /*A park with the given name already exists*/
+#define ST_INVALID_CAPACITY 11 /*The capacity of the park is not positive*/
+#define ST_INVALID_COST 12     /*The prices of the park are not increasing*/
+#define ST_TOO_MANY_PARKS 13   /*There are already MAX_PARKS parks*/
+#define ST_OVERFLOW 14         /*An amount does not fit in a binary frame*/
+
+/*-----------\
+| STRUCTURES |
+\-----------*/
+
+/**
+ * @brief Structure to hold a record of a vehicle.
+ *
+ * @param park The id of the park.
+ * @param entry The date and time of the entry.
+ * @param exit The date and time of the exit, or 0 if the vehicle is inside.
+ */
+typedef struct {
+  int park;
+  Stamp entry, exit;
+} ParkVisit;
+
+/**
+ * @brief Structure to hold the total billed by a park on a day.
+ *
+ * @param day The day.
+ * @param total The total billed on that day.
+ */
+typedef struct {
+  int day;
+  Cents total;
+} ParkDay;
+
+/**
+ * @brief Structure to hold a payment at the exit of a vehicle.
+ *
+ * @param plate The encoded license plate of the vehicle.
+ * @param park The id of the park.
+ * @param entry The date and time of the entry.
+ * @param exit The date and time of the exit.
+ * @param paid The amount paid.
+ */
+typedef struct {
+  Plate plate;
+  int park;
+  Stamp entry, exit;
+  Cents paid;
+} ParkPayment;
+
+/*-----------\
+| FUNCTIONS  |
+\-----------*/
+
+/*library.c*/
+ParkSystem *parkOpen(void);
+void parkRetain(ParkSystem *s, int records, int days);
+void parkClose(ParkSystem *s);
+Plate parkPlate(const char *text);
+int parkDay(int day, int month, int year);
+Stamp parkStamp(int day, int hour, int minute);
+int parkFind(ParkSystem *s, const char *name);
+int parkAdd(ParkSystem *s, const char *name, int capacity, Cents first,
+            Cents next, Cents daily, int *id);
+int parkRemove(ParkSystem *s, int park);
+int parkEnter(ParkSystem *s, int park, Plate plate, Stamp now, int *spots);
+int parkExit(ParkSystem *s, int park, Plate plate, Stamp now,
+             ParkPayment *payment);
+int parkVehicle(ParkSystem *s, Plate plate, ParkVisit **visits, int *count);
+int parkVehicleDates(ParkSystem *s, Plate plate, int from, int to,
+                     ParkVisit **visits, int *count);
+int parkBills(ParkSystem *s, int park, ParkDay **days, int *count);
+int parkBillsDate(ParkSystem *s, int park, int day, ParkPayment **payments,
+                  int *count);
+int parkBillsRange(ParkSystem *s, int park, int from, int to, Cents *total);
+int parkCommand(ParkSystem *s, const char *command);
+
+#endif
@@ -12,7 +12,6 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
 #include "project.h"
 
@@ -26,13 +25,15 @@
  * @param array The array of Node pointers to be sorted.
  * @param n The number of elements in the array.
  * @param compar A pointer to a comparison function. This function should take
- * two void pointers (these will be pointers to Nodes), and should return a
- * negative integer if the first node should come before the second, zero if
- * they are equal, and a positive integer if the first node should come after
- * the second.
+ * two void pointers (these will be pointers to Nodes) and the context, and
+ * should return a negative integer if the first node should come before the
+ * second, zero if they are equal, and a positive integer if the first node
+ * should come after the second.
+ * @param ctx A pointer passed to the comparison function.
  */
 static void insertionSort(Node** array, int n,
-                          int (*compar)(const void*, const void*)) {
+                          int (*compar)(const void*, const void*, void*),
+                          void* ctx) {
   int i, j;
   Node* key;
   for (i = 1; i < n; i++) {
@@ -41,7 +42,7 @@ static void insertionSort(Node** array, int n,
     /* Move elements of array[0..i-1], that are
     greater than key, to one position ahead
     of their current position */
-    while (j >= 0 && compar(&array[j], &key) > 0) {
+    while (j >= 0 && compar(&array[j], &key, ctx) > 0) {
       array[j + 1] = array[j];
       j = j - 1;
     }
@@ -52,157 +53,199 @@ static void insertionSort(Node** array, int n,
 /**
  * @brief Compares the names of the parks in two nodes.
  *
- * This function compares the names of two parks. It is intended to be used as
- * a comparison function `insertionSort`.
+ * This function compares the names of the parks of two records by their rank
+ * in lexicographic order, so no strings are compared. It is intended to be
+ * used as a comparison function `insertionSort`.
  *
  * @param a A pointer to the first node to be compared.
  * @param b A pointer to the second node to be compared.
+ * @param ctx The park table, to find the parks of the records.
  * @return Returns a negative integer if the name of the park in the first node
  * comes before the name of the park in the second node in lexicographic order,
  * zero if they are equal, and a positive integer if the name of the park in
  * the first node comes after the name of the park in the second node.
  */
-static int compareNames(const void* a, const void* b) {
+static int compareNames(const void* a, const void* b, void* ctx) {
+  Park** parkTable = ctx;
   Node* nodeA = *(Node**)a;
   Node* nodeB = *(Node**)b;
-  return strcmp(nodeA->item.record->park->name,
-                nodeB->item.record->park->name);
-}
-/**
- * @brief Compares the names of two parks.
- *
- * This function compares the names of two parks. It is intended to be used as
- * a comparison function `insertionSort`.
- *
- * @param a A pointer to the first node to be compared.
- * @param b A pointer to the second node to be compared.
- * @return Returns a negative integer if the name of the first park comes
- * before the name of the second park in lexicographic order, zero if they are
- * equal, and a positive integer if the name of the first park comes after the
- * name of the second park.
- */
-static int compareParkNames(const void* a, const void* b) {
-  Node* nodeA = *(Node**)a;
-  Node* nodeB = *(Node**)b;
-  return strcmp(nodeA->item.park->name, nodeB->item.park->name);
+  return parkTable[nodeA->item.record->park]->rank -
+         parkTable[nodeB->item.record->park]->rank;
 }
 
 /**
- * @brief Sorts a list of nodes.
+ * @brief Sorts consecutive nodes of a list.
  *
- * This function sorts a list of nodes in ascending order using the insertion
+ * This function sorts nodes of a list in ascending order using the insertion
  * sort algorithm. The comparison function passed as a parameter is used to
  * determine the order of the nodes.
  *
- * @param l A pointer to the list to be sorted.
- * @param compar A pointer to a comparison function. This function should take
- * two void pointers (these will be pointers to Nodes), and should return a
- * negative integer if the first node should come before the second, zero if
- * they are equal, and a positive integer if the first node should come after
- * the second.
+ * @param first A pointer to the first node to be sorted.
+ * @param count The number of nodes to be sorted, from `first` on.
+ * @param compar A pointer to a comparison function, as in `insertionSort`.
+ * @param ctx A pointer passed to the comparison function.
  * @return Returns a pointer to an array of Node pointers sorted in ascending
  * order according to the comparison function. The caller is responsible for
  * freeing this array when it is no longer needed.
  */
-static Node** sortList(List* l, int (*compar)(const void*, const void*)) {
+static Node** sortList(Node* first, int count,
+                       int (*compar)(const void*, const void*, void*),
+                       void* ctx) {
   // Allocate an array of pointers to Node
-  Node** array = malloc(l->size * sizeof(Node*));
+  Node** array = malloc((count > 0 ? count : 1) * sizeof(Node*));
+  long span = traceBegin();
 
   // Fill the array with pointers to the nodes in the list
-  Node* node = l->head;
-  for (int i = 0; i < l->size; i++) {
+  Node* node = first;
+  for (int i = 0; i < count; i++) {
     array[i] = node;
     node = node->next;
   }
 
-  insertionSort(array, l->size, compar);
-
+  insertionSort(array, count, compar, ctx);
+  traceEnd("sortList", span);
   return array;
 }
 
+/**
+ * @brief Sorts records of a vehicle by the name of their park.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param first A pointer to the node of the first record to be sorted.
+ * @param count The number of records to be sorted, from `first` on.
+ * @return Returns a pointer to an array of the nodes, sorted by the name of
+ * the park of their record. The caller is responsible for freeing this array.
+ */
+Node** sortRecords(Memory* m, Node* first, int count) {
+  return sortList(first, count, compareNames, m->parkTable);
+}
+
 /**
  * @brief Prints the records of a vehicle.
  *
- * This function prints the records of a vehicle with a given license plate.
- * The records are sorted by the name of the park, and each record is printed
- * on a separate line. Each line includes the name of the park, the entry date
- * and time, and the exit date and time if the vehicle has exited the park.
+ * This function prints the records of a vehicle with a given license plate
+ * between two days, as listed by `parkVehicleDates`. The records are sorted
+ * by the name of the park, and each record is printed on a separate line.
+ * Each line includes the name of the park, the entry date and time, and the
+ * exit date and time if the vehicle has exited the park.
  *
  * @param m A pointer to the Memory structure.
- * @param plates The license plate of the vehicle.
- * @return Returns 0 if the records are successfully printed, or 1 if there are
- * no records for the vehicle or an error occurs.
+ * @param plate The encoded license plate of the vehicle.
+ * @param from The first day of the records, 0 for all of them.
+ * @param to The last day of the records, INT_MAX for all of them.
+ * @return Returns 1 if the records are successfully printed, or 0 if there
+ * are no records for the vehicle.
  */
-int printRecords(Memory* m, char* plates) {
+int printRecords(Memory* m, Plate plate, int from, int to) {
   // Temporary placeholders for date and time
   char date[11], date2[11], time[6], time2[6];
-  List* l = getListPlates(m->cars, plates);
-  if (l && l->size > 0) {
-    Node** array = sortList(l, compareNames);
-    for (int i = 0; i < l->size; i++) {
-      Record* r = array[i]->item.record;
-      if (!r->exitDay) {
-        intToDate(r->entryDay, date);
-        intToTime(r->entryHour, time);
-        printf("%s %s %s\n", r->park->name, date, time);
-      } else {
-        intToDate(r->entryDay, date);
-        intToTime(r->entryHour, time);
-        intToDate(r->exitDay, date2);
-        intToTime(r->exitHour, time2);
-        printf("%s %s %s %s %s\n", r->park->name, date, time, date2, time2);
-      }
+  ParkVisit* visits;
+  int count;
+  if (parkVehicleDates(m, plate, from, to, &visits, &count) != ST_OK) {
+    return 0;
+  }
+  for (int i = 0; i < count; i++) {
+    char* name = getParkById(m, visits[i].park)->name;
+    intToDate(STAMP_DAY(visits[i].entry), date);
+    intToTime(STAMP_TIME(visits[i].entry), time);
+    if (visits[i].exit == NO_STAMP) {
+      fprintf(m->out, "%s %s %s\n", name, date, time);
+    } else {
+      intToDate(STAMP_DAY(visits[i].exit), date2);
+      intToTime(STAMP_TIME(visits[i].exit), time2);
+      fprintf(m->out, "%s %s %s %s %s\n", name, date, time, date2, time2);
     }
-    free(array);
-    return 1;
   }
-  return 0;
+  free(visits);
+  return 1;
 }
 
 /**
- * @brief Prints the records of a vehicle.
+ * @brief Prints the exits of a park on a day.
  *
- * This function prints the records of a vehicle with a given license plate and
- * specific date. The records are sorted by the name of the park, and each
- * record is printed on a separate line. Each line includes the name of the
- * park, the entry date and time, and the exit date and time.
+ * This function prints the exits of the park on the day, in the order in
+ * which they happened, with `billsPrintDate`. Each line includes the license
+ * plate, the exit time and the amount paid.
  *
  * @param m A pointer to the Memory structure.
- * @param plates The license plate of the vehicle.
+ * @param park The id of the park.
+ * @param date The day of the exits to be printed.
  */
-void printBillsDate(List* r, int date) {
-  Node* n = r->head;
-  for (int i = 0; i < r->size; i++) {
-    if (date == n->item.record->exitDay) {
-      char time[6];
-      intToTime(n->item.record->exitHour, time);
-      printf("%s %s %.2f\n", n->item.record->plates, time,
-             n->item.record->paid);
-    }
-
-    n = n->next;
+void printBillsDate(Memory* m, int park, int date) {
+  Park* p = getParkById(m, park);
+  if (p) {
+    billsPrintDate(p, date, m->out);
   }
 }
 /**
  * @brief Prints the bills for a specific park.
  *
- * This function calculates the sums of the charges for each day for a specific
- * park and prints them. For each day, it prints the date and the total amount
+ * This function prints the total charged by the park on each day, with
+ * `billsPrint`. For each day, it prints the date and the total amount
  * charged on that day.
  *
- * @param l A pointer to the list of records.
+ * @param m A pointer to the Memory structure.
+ * @param park The id of the park.
+ */
+void printBills(Memory* m, int park) {
+  Park* p = getParkById(m, park);
+  if (p) {
+    billsPrint(p, m->out);
+  }
+}
+/**
+ * @brief Prints the bills of the whole network.
+ *
+ * This function calculates the sums of the charges for each day
+ * across all parks and prints them, one day per line with the date and the
+ * total amount charged on that day. It then prints the name of each park and
+ * the total amount charged by it, in the order in which the parks were
+ * created.
+ *
+ * @param l A pointer to the list of parks.
+ * @param out The stream to print to.
  */
-void printBills(List* l) {
+void printNetworkBills(List* l, FILE* out) {
   // temporary placeholder for date
   char date[11];
-  List* newList = calculateSums(l);
+  Cents* subtotals = malloc(sizeof(Cents) * (l->size + 1));
+  List* newList = calculateNetworkSums(l, subtotals);
   Node* n = newList->head;
   for (int i = 0; i < newList->size; i++) {
     intToDate(n->item.dateSum->exitDay, date);
-    printf("%s %.2f\n", date, n->item.dateSum->charged);
+    fprintf(out, "%s " CENTS_FMT "\n", date,
+            CENTS_ARG(n->item.dateSum->charged));
+    n = n->next;
+  }
+  n = l->head;
+  for (int i = 0; i < l->size; i++) {
+    fprintf(out, "%s " CENTS_FMT "\n", n->item.park->name,
+            CENTS_ARG(subtotals[i]));
     n = n->next;
   }
   freeDateSumList(newList);
+  free(subtotals);
+}
+/**
+ * @brief Prints the top vehicles of a ranking.
+ *
+ * This function prints, from the highest to the lowest, up to `k` vehicles of
+ * a ranking. Each line includes the license plate, the number of visits and
+ * the total amount paid.
+ *
+ * @param t A pointer to the ranking.
+ * @param k The maximum number of vehicles to print.
+ * @param out The stream to print to.
+ */
+void printTop(TopK* t, int k, FILE* out) {
+  Tally* sorted[TOP_K];
+  char plates[9];
+  int size = topKSorted(t, sorted);
+  for (int i = 0; i < size && i < k; i++) {
+    decodePlate(sorted[i]->plate, plates);
+    fprintf(out, "%s %d " CENTS_FMT "\n", plates, sorted[i]->visits,
+            CENTS_ARG(sorted[i]->paid));
+  }
 }
 /**
  * @brief Prints the exit record for a vehicle.
@@ -211,34 +254,36 @@ void printBills(List* l) {
  * license plate, the entry date and time, the exit date and time, and the
  * amount paid. Each piece of information is printed on a separate line.
  *
+ * @param p A pointer to the Park structure of the record.
  * @param r A pointer to the Record structure that contains the exit record to
  * be printed.
+ * @param out The stream to print to.
  */
-void printSaida(Record* r) {
+void printSaida(Park* p, Record* r, FILE* out) {
   // temporary place holders for date and time
-  char date[11], date2[11], time[6], time2[6];
-  intToDate(r->entryDay, date);
-  intToTime(r->entryHour, time);
-  intToDate(r->exitDay, date2);
-  intToTime(r->exitHour, time2);
-  printf("%s %s %s %s %s %.2f\n", r->plates, date, time, date2, time2,
-         r->paid);
+  char date[11], date2[11], time[6], time2[6], plates[9];
+  Cents paid = calculatePrice(p, r);
+  decodePlate(r->plate, plates);
+  intToDate(STAMP_DAY(r->entry), date);
+  intToTime(STAMP_TIME(r->entry), time);
+  intToDate(STAMP_DAY(r->exit), date2);
+  intToTime(STAMP_TIME(r->exit), time2);
+  fprintf(out, "%s %s %s %s %s " CENTS_FMT "\n", plates, date, time, date2,
+          time2, CENTS_ARG(paid));
 }
 /**
  * @brief Prints the names of all remaining parks.
  *
- * This function sorts the list of parks in ascending order by name and prints
- * the name of each park on a separate line. The parks are sorted using the
- * `compareParkNames` function.
+ * This function prints the name of each park on a separate line, in ascending
+ * order by name. The parks are already kept sorted by name, so they are not
+ * sorted here.
  *
- * @param l A pointer to the list of parks.
+ * @param m A pointer to the Memory structure.
  */
-void printRemainingParks(List* l) {
-  Node** array = sortList(l, compareParkNames);
-  for (int i = 0; i < l->size; i++) {
-    printf("%s\n", array[i]->item.park->name);
+void printRemainingParks(Memory* m) {
+  for (int i = 0; i < m->parks->size; i++) {
+    fprintf(m->out, "%s\n", m->byName[i]->name);
   }
-  free(array);
 }
 
 /**
@@ -249,14 +294,128 @@ void printRemainingParks(List* l) {
  * vehicles currently in the park, and the park's hourly rate.
  *
  * @param l A pointer to the list of parks.
+ * @param out The stream to print to.
  */
-void printParks(List* l) {
+void printParks(List* l, FILE* out) {
   Node* n = l->head;
   for (int i = 0; i < l->size; i++) {
     {
-      printf("%s %d %d\n", n->item.park->name, n->item.park->capacity,
+      fprintf(out, "%s %d %d\n", n->item.park->name, n->item.park->capacity,
              n->item.park->capacity - n->item.park->occupancy);
       n = n->next;
     }
   }
 }
+
+/**
+ * @brief Writes a binary frame.
+ *
+ * @param f A pointer to the frame.
+ * @param out The stream to write to.
+ */
+void writeFrame(Frame* f, FILE* out) {
+  uint8_t bytes[FRAME_SIZE];
+  packFrame(f, bytes);
+  fwrite(bytes, 1, FRAME_SIZE, out);
+}
+
+/**
+ * @brief Writes the records of a vehicle as binary frames.
+ *
+ * This function is the binary counterpart of `printRecords`. The header frame
+ * is written with the number of records in `a`, followed by one frame per
+ * record, sorted by the name of the park, with the id of the park, the entry
+ * in `a` and the exit, or NO_STAMP, in `b`.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param plate The encoded license plate of the vehicle.
+ * @param head A pointer to the header frame of the response.
+ * @param out The stream to write to.
+ * @return Returns 1 if the records are written, or 0 if there are no records
+ * for the vehicle.
+ */
+int writeRecords(Memory* m, Plate plate, Frame* head, FILE* out) {
+  ParkVisit* visits;
+  int count;
+  if (parkVehicle(m, plate, &visits, &count) != ST_OK) {
+    return 0;
+  }
+  head->a = count;
+  writeFrame(head, out);
+  for (int i = 0; i < count; i++) {
+    Frame f = {CM_PRINT_VEHICLES, ST_OK, visits[i].park, plate,
+               visits[i].entry, visits[i].exit};
+    writeFrame(&f, out);
+  }
+  free(visits);
+  return 1;
+}
+
+/**
+ * @brief Writes the bills of a park as binary frames.
+ *
+ * This function is the binary counterpart of `printBills`. The header frame
+ * is written with the number of days in `a`, followed by one frame per day
+ * with the day in `a` and the amount charged, in cents, in `b`, or with
+ * status ST_OVERFLOW and no more frames if an amount does not fit in `b`.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param park The id of the park.
+ * @param head A pointer to the header frame of the response.
+ * @param out The stream to write to.
+ */
+void writeBills(Memory* m, int park, Frame* head, FILE* out) {
+  ParkDay* days;
+  int count, status = parkBills(m, park, &days, &count);
+  head->status = status;
+  for (int i = 0; status == ST_OK && i < count; i++) {
+    if (!fitsFrame(days[i].total)) {
+      head->status = ST_OVERFLOW;
+    }
+  }
+  head->a = head->status == ST_OK ? count : 0;
+  writeFrame(head, out);
+  for (int i = 0; i < (int)head->a; i++) {
+    Frame f = {CM_GET_BILLS, ST_OK, park, 0, days[i].day, days[i].total};
+    writeFrame(&f, out);
+  }
+  if (status == ST_OK) {
+    free(days);
+  }
+}
+
+/**
+ * @brief Writes the exits of a park on a day as binary frames.
+ *
+ * This function is the binary counterpart of `printBillsDate`. The header
+ * frame is written with the number of exits in `a`, followed by one frame per
+ * exit with the license plate, the exit in `a` and the amount paid, in cents,
+ * in `b`, or with status ST_OVERFLOW and no more frames if an amount does not
+ * fit in `b`.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param park The id of the park.
+ * @param date The day of the exits to be written.
+ * @param head A pointer to the header frame of the response.
+ * @param out The stream to write to.
+ */
+void writeBillsDate(Memory* m, int park, int date, Frame* head, FILE* out) {
+  ParkPayment* payments;
+  int count, status = parkBillsDate(m, park, date, &payments, &count);
+  head->status = status;
+  for (int i = 0; status == ST_OK && i < count; i++) {
+    if (!fitsFrame(payments[i].paid)) {
+      head->status = ST_OVERFLOW;
+    }
+  }
+  head->a = head->status == ST_OK ? count : 0;
+  writeFrame(head, out);
+  for (int i = 0; i < (int)head->a; i++) {
+    Frame f = {CM_GET_BILLS, ST_OK, park, payments[i].plate, payments[i].exit,
+               payments[i].paid};
+    writeFrame(&f, out);
+  }
+  if (status == ST_OK) {
+    free(payments);
+  }
+}
@@ -15,63 +15,158 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * @brief Executes a command.
+ * @brief Reads the options of the program.
  *
- * This function executes a command based on the first character of the command
- * string. It uses a switch statement to determine which command to execute.
- * The commands include adding a vehicle, getting bills, adding a park,
- * removing a park, and exiting a vehicle.
+ * The option -q prints only the errors and -Q only counts them. In both
+ * cases a summary of the run is printed at the end. The option -b reads and
+ * writes binary frames instead of text, and cannot be used with the others.
+ * The option -s serves the clients of a Unix domain socket instead of stdin,
+ * and -r gives the server reader threads for the queries. The option -n
+ * sizes the storage of the records for the number of records expected, and
+ * -e names the shared memory where the changes are published, and -t the
+ * file the trace of the commands is written to. The options -k and -d keep
+ * only the last records, or the records of the last days, of each vehicle,
+ * see `retainRecords`, and -l detects the vehicles inside for longer than a
+ * number of minutes, see wheel.c. The arguments
+ * after the options are inputs to be merged by time instead of stdin, see
+ * merge.c.
  *
- * @param m A pointer to the Memory structure that contains the current state
- * of the system.
- * @param command The first character of the command string.
- * @param buffer The command string.
+ * @param m A pointer to the Memory structure.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param binary A pointer to where the use of binary frames is stored.
+ * @param path A pointer to where the path of the socket, or NULL, is stored.
+ * @param readers A pointer to where the number of reader threads is stored.
+ * @param events A pointer to where the name of the event ring, or NULL, is
+ * stored.
+ * @param trace A pointer to where the path of the trace, or NULL, is stored.
+ * @param inputs A pointer to where the position of the first input in the
+ * arguments, or `argc` if there are none, is stored.
+ * @return Returns 1 if the options are valid, or 0 after printing the usage.
  */
-void execute(Memory *m, char command, char *buffer) {
-  switch (command) {  // sorting the command according to first char
-    case CM_ADD_VEHICLE:
-      processCommand_e(m, buffer);
-      break;
-    case CM_GET_BILLS:
-      processCommand_f(m, buffer);
-      break;
-    case CM_ADD_PARK:
-      processCommand_p(m, buffer);
-      break;
-    case CM_REMOVE_PARK:
-      processCommand_r(m, buffer);
-      break;
-    case CM_EXIT_VEHICLE:
-      processCommand_s(m, buffer);
-      break;
-    case CM_PRINT_VEHICLES:
-      processCommand_v(m, buffer);
+static int readOptions(Memory *m, int argc, char *argv[], int *binary,
+                       char **path, int *readers, char **events,
+                       char **trace, int *inputs) {
+  int valid = 1;
+  *binary = 0;
+  *path = NULL;
+  *readers = 0;
+  *events = NULL;
+  *trace = NULL;
+  *inputs = argc;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+      *inputs = i;  // every argument from here on is an input
       break;
+    } else if (strcmp(argv[i], "-q") == 0) {
+      m->output = OUTPUT_ERRORS;
+    } else if (strcmp(argv[i], "-Q") == 0) {
+      m->output = OUTPUT_NONE;
+    } else if (strcmp(argv[i], "-b") == 0) {
+      *binary = 1;
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      *path = argv[++i];
+    } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      long records = atol(argv[++i]);
+      valid = valid && records > 0 && records <= MAX_EXPECTED;
+      if (valid) {
+        expectRecords(m, records);
+      }
+    } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+      m->keepRecords = atoi(argv[++i]);
+      valid = valid && m->keepRecords > 0;
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      m->keepDays = atoi(argv[++i]);
+      valid = valid && m->keepDays > 0;
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      int minutes = atoi(argv[++i]);
+      valid = valid && minutes > 0 && !m->wheel;
+      if (valid) {
+        m->wheel = wheelNew(minutes);
+      }
+    } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+      *events = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      *trace = argv[++i];
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      *readers = atoi(argv[++i]);
+      valid = valid && *readers > 0 && *readers <= MAX_READERS;
+    } else {
+      valid = 0;
+    }
   }
+  if (!valid || (*binary && (m->output != OUTPUT_ALL || *path)) ||
+      (*readers && !*path) || (*inputs < argc && (*binary || *path))) {
+    fprintf(stderr,
+            "usage: %s [-n <records>] [-k <records>] [-d <days>] [-l <minutes>] "
+            "[-e <events>] [-t <trace>] "
+            "[[-q|-Q] [-s <socket> [-r <readers>] | <input>...] | -b]\n",
+            argv[0]);
+    return 0;
+  }
+  return 1;
 }
 
 /**
  * @brief Main function of the program. Reads commands from stdin and acts
  * accordingly.
  *
- * The function first initializes the system memory. Then, it enters a loop
- * where it reads commands from stdin. Calls the execute function. The loop
- * continues until it reads the exit command or reaches the end of the file.
+ * The function first initializes the system memory and reads the options.
+ * Then, it enters a loop where it reads commands from stdin. Calls the execute
+ * function. The loop continues until it reads the exit command or reaches the
+ * end of the file. In the quiet modes, the summary of the run is printed last.
+ * In binary mode, the commands are read as frames by `serveFrames`, and in
+ * server mode they come from the clients of `serveSocket`. Given inputs,
+ * their commands are merged by `serveStreams`. With an event ring or a
+ * trace, they are opened first and closed last.
  *
- * @return Always returns 0.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return Returns 0, or 1 if the options are not valid or the socket, an
+ * input, the event ring or the trace cannot be opened.
  */
-int main() {
+int main(int argc, char *argv[]) {
   Memory *m = malloc(sizeof(Memory));
   char *buffer = malloc(sizeof(char) * BUF_SIZE + 1);
+  char *path, *events, *trace;
   char command;  // stores the first char in stdin that is the command
+  int valid, binary, readers, inputs;
   initializeSystem(m);
-  while ((command = getchar()) != CM_EXIT && command != EOF) {
-    readLine(buffer);
-    execute(m, command, buffer);
+  valid = readOptions(m, argc, argv, &binary, &path, &readers, &events,
+                      &trace, &inputs);
+  if (valid && events && !(m->events = eventsCreate(events))) {
+    perror(events);
+    valid = 0;
+  }
+  if (valid && trace && !traceOpen(trace)) {
+    perror(trace);
+    valid = 0;
+  }
+  if (valid && binary) {
+    serveFrames(m, stdin, stdout);
+  } else if (valid) {
+    if (path) {
+      valid = serveSocket(m, path, readers);
+    } else if (inputs < argc) {
+      valid = serveStreams(m, argc - inputs, argv + inputs);
+    } else {
+      while ((command = getchar()) != CM_EXIT && command != EOF) {
+        readLine(buffer);
+        execute(m, command, buffer);
+      }
+    }
+    if (valid && m->output != OUTPUT_ALL) {
+      printSummary(m);
+    }
+  }
+  traceClose();
+  if (m->events) {
+    eventsClose(m->events, events);
   }
   cleanUp(m);
   free(buffer);
-  return 0;
-}
\ No newline at end of file
+  return valid ? 0 : 1;
+}
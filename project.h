@@ -18,12 +18,50 @@
 \-------*/
 #ifndef MAIN_H
 #define MAIN_H
-#define NO_DATE 0      /*Used to mark if theres no date*/
-#define NO_TIME 0      /*Used to mark if theres no date*/
-#define HASH_SIZE 8191 /*Hashtable size*/
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "park.h"
+
+#define NO_STAMP 0     /*Used to mark if theres no date and time*/
+#define NO_PARK UINT16_MAX  /*Used to mark a free slot in the park table*/
+#define HASH_SIZE 8191 /*Initial hashtable size*/
+#define MAX_YEAR 8000  /*Last year whose minutes fit in a Stamp*/
+#define MINUTES_PER_DAY (24 * 60) /*Number of minutes in a day*/
 
 #define MAX_PARKS 20  /*Maximum number of parques in the program*/
 #define BUF_SIZE 8192 /*Default buffer size limit*/
+#define TOP_K 16             /*Number of vehicles kept in each ranking*/
+#define RANK_SPEND 0         /*Ranking of vehicles by amount paid*/
+#define RANK_VISITS 1        /*Ranking of vehicles by number of visits*/
+#define MAX_REASONS 32       /*Maximum distinct errors counted in a summary*/
+#define SERVER_EVENTS 64     /*Maximum events handled per server loop*/
+#define MAX_READERS 16       /*Maximum reader threads of the server*/
+#define NO_EPOCH -1          /*Epoch of a reader that is not reading*/
+#define PREFETCH_WINDOW 16   /*Maximum frames whose lookups are overlapped*/
+#define FRAME_SIZE 16        /*Bytes of a frame of the binary protocol*/
+#define PREFETCH_LEVELS 5    /*Levels prefetched per vehicle, see hashPrefetch*/
+#define HUGE_PAGE_SIZE (2UL << 20) /*Size of a huge page of the machine*/
+#define MAX_EXPECTED (1L << 28)    /*Largest expected number of records*/
+#define EVENT_RING_SIZE (1 << 16)  /*Events kept in the event ring*/
+#define EVENT_NAME 32              /*Size of the park name of an event*/
+#define EVENT_MAGIC 0x56454b50     /*"PKEV", first bytes of the event ring*/
+#define CACHE_LINE 64              /*Size of a cache line of the machine*/
+#define PLATE_STRIPES 64           /*Locks the vehicles are spread over*/
+#define TRACE_SIZE (1UL << 20)     /*Spans kept in the ring of the trace*/
+#define VISIT_STRIDE 32            /*Records of a vehicle between its marks*/
+#define WHEEL_BITS 6               /*Bits of a minute at a level of the wheel*/
+#define WHEEL_SLOTS (1 << WHEEL_BITS) /*Slots of a level of the wheel*/
+#define WHEEL_LEVELS 6             /*Levels of the wheel, for 32-bit minutes*/
+#define RECORD_EVICTED 1           /*Flag of a record its vehicle dropped*/
+#define STAY_PRECISION 5           /*Bits of a stay kept exact by the sketch*/
+#define STAY_BUCKETS ((33 - STAY_PRECISION) << STAY_PRECISION) /*Of a sketch*/
+
+#define OUTPUT_ALL 0    /*Prints every result and error*/
+#define OUTPUT_ERRORS 1 /*Prints only errors, then a summary*/
+#define OUTPUT_NONE 2   /*Only counts errors, then prints a summary*/
 
 /*---------\
 | COMMANDS |
@@ -36,6 +74,15 @@
 #define CM_PRINT_VEHICLES 'v' /*Command to print vehicles*/
 #define CM_REMOVE_PARK 'r'    /*Command to remove a park*/
 #define CM_GET_BILLS 'f'      /*Command to get parks billing*/
+#define CM_NETWORK_BILLS 'n'  /*Command to get billing of all parks*/
+#define CM_TOP_VEHICLES 't'   /*Command to get the top vehicles*/
+#define CM_OCCUPANCY 'o'      /*Command to get the past occupancy of a park*/
+#define CM_IMPORT 'i'         /*Command to bulk import records from a file*/
+#define CM_EXPORT 'x'         /*Command to export every record to a file*/
+#define CM_STATS 'u'          /*Command to get the statistics of the parks*/
+#define CM_TEXT 'T'           /*Binary frame carrying a text command*/
+#define CM_WRITE_TRACE 'w'    /*Command to write the trace to its file*/
+#define CM_OVERSTAYS 'l'      /*Command to list the vehicles that overstay*/
 
 /*---------------\
 | ERROR MESSAGES |
@@ -52,40 +99,157 @@
 #define ERR_INVALID_EXIT(p) "%s: invalid vehicle exit.\n", p
 #define ERR_TOO_MANY_PARKS "too many parks.\n"
 #define ERR_NO_ENTRYS_FOUND(p) "%s: no entries found in any parking.\n", p
+#define ERR_INVALID_RANKING(r) "%s: invalid ranking.\n", r
+#define ERR_INVALID_TOP_SIZE(k) "%d: invalid ranking size.\n", k
+#define ERR_CANNOT_OPEN(f) "%s: cannot open file.\n", f
+#define ERR_CANNOT_WRITE(f) "%s: cannot write file.\n", f
+#define ERR_IMPORT_LINE(f, l) "%s:%ld: ", f, l
+#define ERR_INVALID_FORMAT "invalid format.\n"
 
-typedef unsigned long int Key; /* tipo da chave */
-#define key(a) (sumAsciiValues(a->plates))
+typedef Plate Key;      /* tipo da chave */
+#define key(a) (a->plate)
+
+/*Converts a date and a time into a Stamp, and a Stamp back to them*/
+#define STAMP(d, t) ((Stamp)(d) * MINUTES_PER_DAY + (Stamp)(t))
+#define STAMP_DAY(s) ((int)((s) / MINUTES_PER_DAY))
+#define STAMP_TIME(s) ((int)((s) % MINUTES_PER_DAY))
+#define LAST_STAMP STAMP((MAX_YEAR + 1) * 365, MINUTES_PER_DAY - 1)
+
+/*Format and arguments to print an amount of Cents as euros*/
+#define CENTS_FMT "%ld.%02ld"
+#define CENTS_ARG(c) (c) / 100, (c) % 100
 
 /*-----------\
 | STRUCTURES |
 \-----------*/
 
+/**
+ * @brief Structure to hold the occupancy history of a park.
+ *
+ * @param stamps The minute of each event, in ascending order.
+ * @param occupancy The occupancy at the end of the minute of each event.
+ * @param peak A segment tree whose leaves, from index `capacity`, hold the
+ * largest occupancy during the minute of each event and whose inner nodes
+ * hold the largest occupancy of their children.
+ * @param size The number of events in the history.
+ * @param capacity The number of events allocated.
+ */
+typedef struct {
+  Stamp *stamps;
+  int *occupancy, *peak;
+  int size, capacity;
+} History;
+
+/**
+ * @brief Structure to hold the running totals of a vehicle.
+ *
+ * A vehicle has one tally for the whole network and one for each park where
+ * it has left. Tallies only grow while their park exists, so the rankings are
+ * kept up to date incrementally.
+ *
+ * @param plate The license plate of the vehicle.
+ * @param parkId The id of the park, or 0 for the network totals.
+ * @param visits The number of exits of the vehicle.
+ * @param paid The total amount paid by the vehicle.
+ * @param pos The position of the tally in each ranking heap, or -1.
+ * @param next The next per-park tally of the vehicle.
+ */
+typedef struct tally {
+  Plate plate;
+  int parkId, visits;
+  Cents paid;
+  int pos[2];
+  struct tally *next;
+} Tally;
+
+/**
+ * @brief Structure to hold the top vehicles of a ranking.
+ *
+ * This structure is a bounded min-heap with the TOP_K largest tallies of a
+ * ranking, so that the smallest of them is at the root.
+ *
+ * @param heap The tallies in the ranking.
+ * @param size The number of tallies in the ranking.
+ * @param kind The ranking, RANK_SPEND or RANK_VISITS.
+ */
+typedef struct {
+  Tally *heap[TOP_K];
+  int size, kind;
+} TopK;
+
 /**
  * @brief A node in a hash table.
  *
  * This structure represents a node in a hash table. Each node has a unique
- * key, which is the sum of the ASCII values of the license plate of a vehicle.
- * The `records` field is a pointer to a list of records associated with the
- * vehicle.
+ * key, which is the encoded license plate of a vehicle. The `records` field is a pointer to a list of records associated with the
+ * vehicle. The `total` and `parks` fields hold the running totals of the
+ * vehicle in the network and in each park. The `marks` field holds every
+ * VISIT_STRIDE-th node of the list of records, from the one at position
+ * VISIT_STRIDE, so the records can be searched by date, see `seekRecords`.
+ * The `dropped` field counts the records dropped from the head of the list
+ * since the marks were built, so the marks keep their positions, see
+ * `retainRecords`. The `timer` field is the timer of the stay of the vehicle
+ * in a park, or NULL, see wheel.c.
  */
 
 typedef struct {
   Key key;
   struct list *records;
+  Tally total;
+  Tally *parks;
+  struct node **marks;
+  int markCount, dropped;
+  struct timer *timer;
 } HashNode;
 
 /**
  * @brief A hash table for storing HashNode objects.
  *
  * This structure represents a hash table. The hash table is an array of
- * pointers to HashNode objects. The size of the array is determined by the
- * HASH_SIZE macro. Each HashNode in the hash table is identified by a unique
- * key, which is the sum of the ASCII values of the license plate of a vehicle.
+ * pointers to HashNode objects. The array starts with HASH_SIZE entries and
+ * grows so that it is never more than half full. Each HashNode in the hash
+ * table is identified by a unique key, which is the encoded license plate of
+ * a vehicle.
  */
 typedef struct {
-  HashNode *plate[HASH_SIZE];
+  HashNode **plate;
+  int size;
+  _Atomic int count;
 } HashTable;
 
+/**
+ * @brief Structure to hold a slab allocator of fixed-size items.
+ *
+ * @param free The freed items, linked through their first bytes.
+ * @param next The first unused byte of the current block.
+ * @param end The end of the current block.
+ * @param blocks The blocks mapped, see `hugeMap`.
+ * @param sizes The size of each block.
+ * @param mapped The total size of the blocks.
+ * @param blockCount The number of blocks mapped.
+ * @param blockCapacity The number of blocks that fit in `blocks`.
+ * @param itemSize The size of each item.
+ * @param lock The spin lock of the slab, taken to allocate and free.
+ */
+typedef struct {
+  void *free;
+  char *next, *end;
+  char **blocks;
+  size_t *sizes, mapped;
+  int blockCount, blockCapacity, itemSize;
+  atomic_flag lock;
+} Slab;
+
+/**
+ * @brief Structure to hold one of the locks the vehicles are spread over,
+ * alone in its cache line.
+ *
+ * @param lock The lock.
+ */
+typedef struct {
+  _Alignas(CACHE_LINE) pthread_mutex_t lock;
+} Stripe;
+
 /**
  * @brief Structure to hold the exit day and the charged amount.
  *
@@ -94,64 +258,537 @@ typedef struct {
  */
 typedef struct {
   int exitDay;
-  float charged;
+  Cents charged;
 } DateSum;
+
+/**
+ * @brief Structure to hold the revenue index of a park.
+ *
+ * @param days The distinct exit days of the park, in ascending order.
+ * @param prefix The total charged from the first day up to each day.
+ * @param size The number of days in the index.
+ * @param capacity The number of days allocated.
+ */
+typedef struct {
+  int *days;
+  Cents *prefix;
+  int size, capacity;
+} Revenue;
+
+/**
+ * @brief Structure to hold text that grows at the end.
+ *
+ * @param chars The characters, not ended by a null character.
+ * @param size The number of characters used.
+ * @param capacity The number of characters allocated.
+ */
+typedef struct {
+  char *chars;
+  long size, capacity;
+} Text;
+
+/**
+ * @brief Structure to hold the billing text of the closed days of a park.
+ *
+ * @param totals The lines of command 'f' with no dates for the closed days.
+ * @param exits The lines of command 'f' with one date for the closed days,
+ * day after day.
+ * @param offsets Where the lines of each closed day start in `exits`, and
+ * where the last one ends.
+ * @param days The number of closed days with exits, the first days of the
+ * revenue index.
+ * @param capacity The number of offsets allocated.
+ * @param until The first day that is not closed.
+ * @param last The node of the last record of the park in the cache, or NULL.
+ */
+typedef struct {
+  Text totals, exits;
+  long *offsets;
+  int days, capacity, until;
+  struct node *last;
+} Bills;
+
+/**
+ * @brief Structure to hold the pool where the park names are interned.
+ *
+ * @param chars The names of the parks, one after the other, each one ended by
+ * a null character.
+ * @param size The number of characters used.
+ * @param capacity The number of characters allocated.
+ */
+typedef struct {
+  char *chars;
+  int size, capacity;
+} NamePool;
+
+/**
+ * @brief Structure to hold the statistics of a park on a day.
+ *
+ * @param day The day.
+ * @param entries The number of entries on the day.
+ * @param exits The number of exits on the day.
+ * @param peak The largest occupancy of the park on the day.
+ */
+typedef struct {
+  int day, entries, exits, peak;
+} DayStats;
+
+/**
+ * @brief Structure to hold the statistics of a park, see stats.c.
+ *
+ * @param days The statistics of each day with entries or exits, in order.
+ * @param size The number of days.
+ * @param capacity The number of days allocated.
+ * @param entries The number of entries.
+ * @param exits The number of exits, which is the number of stays.
+ * @param stayed The total length of the stays, in minutes.
+ * @param stays The sketch of the lengths of the stays.
+ */
+typedef struct {
+  DayStats *days;
+  int size, capacity;
+  long entries, exits, stayed;
+  int stays[STAY_BUCKETS];
+} Stats;
+
 /**
  * @brief Structure to hold the information of a park.
  *
- * @param name The name of the park.
+ * The fields written by entries and exits start in their own cache line,
+ * after the name and prices, which are only read, so gates writing a park do
+ * not slow down the readers of its neighbours' prices. The structure is
+ * allocated aligned to a cache line.
+ *
+ * @param name The name of the park, interned in the pool of names.
+ * @param nameOffset The position of the name in the pool of names.
+ * @param rank The position of the park when sorted by name.
  * @param capacity The maximum capacity of the park.
- * @param occupancy The current occupancy of the park.
  * @param id The id of the park.
- * @param less_60 The cost of 15 minutes of parking for the first 60 minutes.
- * @param more_60 The cost of 15 minutes of parking after the first 60 minutes.
- * @param dayly The cost of a full day of parking or maximum amount chraged in
+ * @param index The position of the park in the park table.
+ * @param less_60 The cost, in cents, of 15 minutes of parking for the first
+ * 60 minutes.
+ * @param more_60 The cost, in cents, of 15 minutes of parking after the first
+ * 60 minutes.
+ * @param dayly The cost, in cents, of a full day of parking or maximum amount
+ * chraged in one day
+ * @param lock The lock taken by entries and exits of the park
  * @param records The list of records of the park
- * one day
+ * @param occupancy The current occupancy of the park.
+ * @param evicted The number of records of the park dropped by their vehicles
+ * and still in its list, see `compactRecords`, changed atomically by the
+ * gates of other parks.
+ * @param revenue The revenue index of the park, by exit day
+ * @param bills The billing text of the closed days of the park
+ * @param top The rankings of the vehicles that have left the park
+ * @param history The occupancy history of the park
+ * @param stats The statistics of the entries, exits and stays of the park
  * */
 typedef struct {
   char *name;
-  int capacity, occupancy, id;
-  float less_60, more_60, dayly;
+  int nameOffset, rank;
+  int capacity, id, index;
+  Cents less_60, more_60, dayly;
+  _Alignas(CACHE_LINE) pthread_mutex_t lock;
   struct list *records;
+  int occupancy;
+  int evicted;
+  Revenue *revenue;
+  Bills *bills;
+  TopK top[2];
+  History *history;
+  Stats *stats;
 } Park;
 
 /**
  * @brief Structure to hold the information of a record.
  *
- * @param plates The license plates of the vehicle.
- * @param park The park where the vehicle is parked.
- * @param entryDay The day the vehicle entered the park.
- * @param entryHour The hour the vehicle entered the park.
- * @param exitDay The day the vehicle exited the park.
- * @param exitHour The hour the vehicle exited the park.
- * @param paid The amount paid by the vehicle.
+ * A record takes 16 bytes. The amount paid is not stored, since it only
+ * depends on the stay and on the tariff of the park, and is given by
+ * `calculatePrice`.
+ *
+ * @param plate The encoded license plate of the vehicle.
+ * @param park The index, in the park table, of the park of the record.
+ * @param flags The flags of the record, each set on its own: RECORD_EVICTED
+ * once the vehicle of the record dropped it, see `retainRecords`.
+ * @param entry The minute the vehicle entered the park.
+ * @param exit The minute the vehicle exited the park, or NO_STAMP.
  *
  */
 
 typedef struct {
-  char plates[9];
-  Park *park;
-  int entryDay, entryHour, exitDay, exitHour;
-  float paid;
+  Plate plate;
+  uint16_t park, flags;
+  Stamp entry, exit;
 } Record;
 
+/**
+ * @brief Structure to hold the timer of the stay of a vehicle in a park.
+ *
+ * @param prev The previous timer in its slot or in the overstays of its park,
+ * or the head of the list.
+ * @param next The next timer, or the head of the list.
+ * @param record The open record of the stay.
+ * @param expires The minute the stay becomes an overstay.
+ */
+typedef struct timer {
+  struct timer *prev, *next;
+  Record *record;
+  Stamp expires;
+} Timer;
+
+/**
+ * @brief Structure to hold the timer wheel of the stays, see wheel.c.
+ *
+ * @param slots The heads of the lists of timers of each slot, by level.
+ * @param used The slots of each level that may have timers, one bit each.
+ * @param overstays The heads of the lists of the timers that expired, by park
+ * index.
+ * @param timers The slab from which the timers are allocated.
+ * @param now The minute the wheel is at.
+ * @param threshold The minutes a vehicle stays before it overstays.
+ * @param lock The lock of the wheel.
+ */
+typedef struct wheel {
+  Timer slots[WHEEL_LEVELS][WHEEL_SLOTS];
+  uint64_t used[WHEEL_LEVELS];
+  Timer overstays[MAX_PARKS];
+  Slab timers;
+  Stamp now, threshold;
+  pthread_mutex_t lock;
+} Wheel;
+
+/**
+ * @brief Structure to hold the counters of a run, printed in quiet modes.
+ *
+ * @param commands The number of commands of each type, by command character.
+ * @param reasons The format of each distinct error message printed.
+ * @param rejections The number of times each error was printed.
+ * @param reasonCount The number of distinct errors.
+ */
+typedef struct {
+  long commands[128];
+  const char *reasons[MAX_REASONS];
+  long rejections[MAX_REASONS];
+  int reasonCount;
+} Summary;
+
+/**
+ * @brief Structure to hold a span of the trace.
+ *
+ * @param name The name of the span.
+ * @param start When the span started, in nanoseconds since the trace started.
+ * @param duration How long the span took, in nanoseconds.
+ * @param thread The number of the thread that recorded the span, from 1.
+ */
+typedef struct {
+  const char *name;
+  long start, duration;
+  int thread;
+} Span;
+
+/**
+ * @brief Structure to hold the trace of the execution of the commands.
+ *
+ * @param spans The ring of the last TRACE_SIZE spans recorded.
+ * @param head The number of spans recorded, the next is `spans[head %
+ * TRACE_SIZE]`.
+ * @param path The path of the JSON file the trace is written to.
+ * @param origin When the trace started, as given by the monotonic clock.
+ */
+typedef struct {
+  Span *spans;
+  _Atomic unsigned long head;
+  const char *path;
+  long origin;
+} Trace;
+
 /**
  * @brief Structure to hold the memory of the system, including the parks and
  * records. It stores that state of the system.
  *
  * @param parks The list of parks in the system.
+ * @param parkTable The parks indexed by the `park` field of the records.
+ * @param byName The parks sorted by name, indexed by their rank.
+ * @param names The pool where the park names are interned.
  * @param cars The Hastable to store vehicle records.
- * @param date The current date of the system.
- * @param time The current time of the system.
+ * @param records The slab from which the records are allocated.
+ * @param nodes The slab of the nodes of the lists of records of the vehicles
+ * and of the parks.
+ * @param vehicles The slab of the nodes of the hash table.
+ * @param lists The slab of the lists of records of the vehicles.
+ * @param now The current date and time of the system, only moved forward by
+ * `updateMemoryTime`.
+ * @param closed The first day whose billing text is not yet rendered in every
+ * park, see `billsClose`.
+ * @param table The lock shared by entries and exits, and taken alone to grow
+ * the hash table, see `lockTable`.
+ * @param stripes The locks of the vehicles, see `lockVehicle`.
+ * @param lock The lock of the network rankings and of the event ring.
  * @param idIncrementer The id of the next park to be added.
+ * @param top The rankings of the vehicles in the whole network.
+ * @param output What is printed, OUTPUT_ALL, OUTPUT_ERRORS or OUTPUT_NONE.
+ * @param out The stream that results and errors are printed to.
+ * @param summary The counters of the run.
+ * @param events The ring the changes are published to, or NULL.
+ * @param keepRecords The number of records kept by each vehicle, or 0 to
+ * keep them all.
+ * @param keepDays The number of days before the current one whose records
+ * are kept by each vehicle, or 0 to keep them all.
+ * @param wheel The timer wheel of the stays, or NULL.
+ * @param imported Where command 'i' writes the rows it imports, as a binary
+ * import file, or NULL.
  */
 typedef struct memory {
   struct list *parks;
+  Park *parkTable[MAX_PARKS];
+  Park *byName[MAX_PARKS];
+  NamePool names;
   HashTable *cars;
-  int date, time, idIncrementer;
+  Slab records, nodes, vehicles, lists;
+  _Atomic Stamp now;
+  _Atomic int closed;
+  pthread_rwlock_t table;
+  Stripe *stripes;
+  pthread_mutex_t lock;
+  int idIncrementer;
+  TopK top[2];
+  int output;
+  FILE *out;
+  Summary summary;
+  struct eventRing *events;
+  int keepRecords, keepDays;
+  struct wheel *wheel;
+  FILE *imported;
 } Memory;
 
+/**
+ * @brief Structure to hold a frame of the binary protocol.
+ *
+ * Requests and responses are frames of FRAME_SIZE bytes, with every field
+ * little-endian, see `packFrame`. The meaning of `a` and `b` depends on the
+ * operation, see protocol.c.
+ *
+ * @param op The command, as in the text format.
+ * @param status Always 0 in requests, one of the ST_ codes in responses.
+ * @param park The id of the park.
+ * @param plate The encoded license plate.
+ * @param a The first argument or result.
+ * @param b The second argument or result.
+ */
+typedef struct {
+  uint8_t op, status;
+  uint16_t park;
+  uint32_t plate, a, b;
+} Frame;
+
+/**
+ * @brief Structure to hold a change published to the event ring.
+ *
+ * Events are 64 bytes, a cache line, in the byte order of the machine. The
+ * meaning of `a`, `b` and `amount` depends on the operation, see events.c.
+ *
+ * @param sequence The number of the event plus 1, or 0 while it is written.
+ * @param op The command, 'e', 's', 'p' or 'r'.
+ * @param park The id of the park.
+ * @param plate The encoded license plate.
+ * @param a The first value.
+ * @param b The second value.
+ * @param amount An amount of money.
+ * @param name The name of the park, cut to EVENT_NAME - 1 characters.
+ */
+typedef struct {
+  _Atomic uint64_t sequence;
+  uint8_t op, unused;
+  uint16_t park;
+  uint32_t plate, a, b;
+  int64_t amount;
+  char name[EVENT_NAME];
+} Event;
+
+/**
+ * @brief Structure to hold the event ring, in shared memory.
+ *
+ * The program is the only writer, and any number of processes read it. The
+ * count of events written is on a cache line of its own.
+ *
+ * @param magic EVENT_MAGIC.
+ * @param capacity The number of events kept, a power of 2.
+ * @param closed Whether the program has stopped writing.
+ * @param head The number of events written.
+ * @param events The last `capacity` events, event `n` in `events[n %
+ * capacity]`.
+ */
+typedef struct eventRing {
+  _Atomic uint32_t magic;
+  uint32_t capacity;
+  _Atomic uint32_t closed;
+  _Alignas(64) _Atomic uint64_t head;
+  _Alignas(64) Event events[];
+} EventRing;
+
+/**
+ * @brief Structure to hold a process reading the event ring.
+ *
+ * @param ring A pointer to the mapped event ring.
+ * @param size The size of the mapping.
+ * @param next The number of the next event to read.
+ */
+typedef struct {
+  const EventRing *ring;
+  size_t size;
+  uint64_t next;
+} EventReader;
+
+/**
+ * @brief Structure to hold a client connected to the server.
+ *
+ * @param fd The socket of the connection.
+ * @param index The position of the client in the array of the server.
+ * @param in The input received and not yet executed.
+ * @param inLength The number of characters in `in`.
+ * @param out The output of the client's commands.
+ * @param outLength The number of characters in `out`.
+ * @param outSent The number of characters of `out` already sent.
+ * @param events The events the server waits for on the socket.
+ * @param done Whether the client ended its input, with 'q' or by closing.
+ * @param waiting Whether a reader thread is running a query of the client.
+ * @param version The version of the last change made by the client.
+ * @param ready Whether the client is to be served in this loop.
+ * @param nextReady The next client to be served in this loop.
+ */
+typedef struct client {
+  int fd;
+  int index;
+  char in[BUF_SIZE + 1];
+  int inLength;
+  char *out;
+  size_t outLength, outSent;
+  uint32_t events;
+  int done;
+  int waiting;
+  long version;
+  int ready;
+  struct client *nextReady;
+} Client;
+
+/**
+ * @brief Structure to hold a query run by a reader thread of the server.
+ *
+ * @param client The client that sent the query.
+ * @param line The query, a command 'v', 'f' or 'p' with no arguments.
+ * @param version The number of changes the replica must have, so that the
+ * query sees the changes of its client.
+ * @param text The output of the query.
+ * @param length The number of characters in `text`.
+ * @param summary The counters of the query, added to those of the server.
+ * @param next The next query in the same queue.
+ */
+typedef struct query {
+  Client *client;
+  char *line;
+  long version;
+  char *text;
+  size_t length;
+  Summary summary;
+  struct query *next;
+} Query;
+
+/**
+ * @brief Structure to hold a copy of the system that the queries read.
+ *
+ * @param copy The copy of the system.
+ * @param version The number of changes of the log applied to the copy.
+ */
+typedef struct {
+  Memory *copy;
+  long version;
+} Replica;
+
+/**
+ * @brief Structure to hold a reader thread of the server.
+ *
+ * @param thread The thread.
+ * @param epoch The epoch in which the reader started its query, or NO_EPOCH.
+ * @param owner The snapshots the reader serves.
+ */
+typedef struct {
+  pthread_t thread;
+  atomic_long epoch;
+  struct snapshots *owner;
+} Reader;
+
+/**
+ * @brief Structure to hold a change in the log of the replicas.
+ *
+ * @param line The command of the change.
+ * @param rows The rows imported by a command 'i', as a binary import file.
+ * @param size The number of bytes of `rows`, 0 if nothing was imported.
+ */
+typedef struct {
+  char *line;
+  char *rows;
+  size_t size;
+} Change;
+
+/**
+ * @brief Structure to hold the snapshots served to the reader threads.
+ *
+ * @param replicas The two copies of the system. In epoch `e`, the queries
+ * read `replicas[e % 2]` and the other one is brought up to date.
+ * @param epoch The number of replicas published so far.
+ * @param log The changes not yet applied to both replicas.
+ * @param first The version of the first change in `log`.
+ * @param count The number of changes in `log`.
+ * @param capacity The size of `log`.
+ * @param queries The queries waiting for a reader.
+ * @param last The last query in `queries`.
+ * @param answered The queries already run, waiting for the server.
+ * @param readers The reader threads.
+ * @param readerCount The number of reader threads.
+ * @param replayer The thread that applies the log to the replicas.
+ * @param output What the queries print, as the `output` of Memory.
+ * @param notify The eventfd through which the server learns of answers.
+ * @param stopping Whether the threads must stop.
+ * @param lock The lock protecting the log and the queues.
+ * @param logged Signaled when a change is added to the log.
+ * @param changed Signaled when a query is queued or a replica published.
+ */
+typedef struct snapshots {
+  Replica replicas[2];
+  atomic_long epoch;
+  Change *log;
+  long first, count, capacity;
+  Query *queries, *last, *answered;
+  Reader readers[MAX_READERS];
+  int readerCount;
+  pthread_t replayer;
+  int output;
+  int notify;
+  int stopping;
+  pthread_mutex_t lock;
+  pthread_cond_t logged, changed;
+} Snapshots;
+
+/**
+ * @brief Structure to hold the state of the server.
+ *
+ * @param epoll The epoll instance of the server.
+ * @param listener The listening socket.
+ * @param clients The connected clients.
+ * @param count The number of connected clients.
+ * @param capacity The size of the array of clients.
+ * @param snapshots The snapshots of the reader threads, or NULL if the
+ * server has none.
+ */
+typedef struct {
+  int epoll;
+  int listener;
+  Client **clients;
+  int count;
+  int capacity;
+  Snapshots *snapshots;
+} Server;
+
 /**
  * @brief Union to store the different types of items that can be stored in a
  * List
@@ -198,55 +835,198 @@ typedef struct list {
 \-----------*/
 
 /*aux_commands.c*/
-int validationsE(Memory *m, Park *p1, Record *r1, char *name, char *plates,
-                 char *data, char *time);
-int validationsP(Memory *m, Park *p1);
-int validationsS(Memory *m, Park *p1, Record *r1, char *name, char *plates,
-                 char *date, char *time);
+int checkEntry(Memory *m, Park *p1, Plate plate, Stamp now);
+int checkPark(Memory *m, Park *p1);
+int checkExit(Memory *m, Park *p1, Plate plate, Stamp now);
 
 /*commands.c*/
+void execute(Memory *m, char command, char *buffer);
+int vehicleEnter(Memory *m, Park *p, Plate plate, Stamp now, int *spots);
+int vehicleExit(Memory *m, Park *p, Plate plate, Stamp now, Record **exited);
+int addPark(Memory *m, char *name, int capacity, Cents first, Cents next,
+            Cents daily, Park **added);
 void processCommand_f(Memory *m, char *buffer);
+void processCommand_n(Memory *m, char *buffer);
+void processCommand_t(Memory *m, char *buffer);
+void processCommand_o(Memory *m, char *buffer);
+void processCommand_u(Memory *m, char *buffer);
+void processCommand_l(Memory *m, char *buffer);
 void processCommand_r(Memory *m, char *buffer);
 void processCommand_v(Memory *m, char *buffer);
 void processCommand_s(Memory *m, char *buffer);
 void processCommand_e(Memory *m, char *buffer);
 void processCommand_p(Memory *m, char *buffer);
 
+/*import.c*/
+void processCommand_i(Memory *m, char *buffer);
+void importRows(Memory *m, char *rows, size_t size);
+
+/*export.c*/
+void processCommand_x(Memory *m, char *buffer);
+
 /*printer.c*/
-void printSaida(Record *r);
-int printRecords(Memory *m, char *plates);
-void printRemainingParks(List *l);
-void printParks(List *l);
-void printBillsDate(List *r, int date);
-void printBills(List *l);
+Node **sortRecords(Memory *m, Node *first, int count);
+void printSaida(Park *p, Record *r, FILE *out);
+int printRecords(Memory *m, Plate plate, int from, int to);
+void printRemainingParks(Memory *m);
+void printParks(List *l, FILE *out);
+void printBillsDate(Memory *m, int park, int date);
+void printBills(Memory *m, int park);
+void printNetworkBills(List *l, FILE *out);
+void printTop(TopK *t, int k, FILE *out);
+void writeFrame(Frame *f, FILE *out);
+int writeRecords(Memory *m, Plate plate, Frame *head, FILE *out);
+void writeBills(Memory *m, int park, Frame *head, FILE *out);
+void writeBillsDate(Memory *m, int park, int date, Frame *head, FILE *out);
+
+/*protocol.c*/
+void packFrame(Frame *f, uint8_t *bytes);
+int readFrame(Frame *f, FILE *in);
+int fitsFrame(Cents amount);
+void serveFrames(Memory *m, FILE *in, FILE *out);
+
+/*server.c*/
+int serveSocket(Memory *m, const char *path, int readers);
+
+/*merge.c*/
+int serveStreams(Memory *m, int count, char *paths[]);
+
+/*trace.c*/
+int traceOpen(const char *path);
+long traceBegin(void);
+void traceEnd(const char *name, long start);
+void traceWrite(void);
+void traceClose(void);
+
+/*snapshot.c*/
+Snapshots *snapshotsStart(Memory *m, int readers);
+long snapshotsLog(Snapshots *s, const char *line, char *rows, size_t size);
+void snapshotsQuery(Snapshots *s, Query *q);
+Query *snapshotsAnswered(Snapshots *s);
+void snapshotsStop(Snapshots *s);
+
+/*events.c*/
+EventRing *eventsCreate(const char *name);
+void eventsClose(EventRing *ring, const char *name);
+void eventsPublish(Memory *m, uint8_t op, Park *p, Plate plate, uint32_t a,
+                   uint32_t b, Cents amount);
+int eventsAttach(EventReader *r, const char *name);
+const Event *eventsPeek(EventReader *r, uint64_t *lost);
+int eventsDone(EventReader *r, const Event *e);
+void eventsDetach(EventReader *r);
 
 /*data_structures.c*/
 List *ListNew();
 void listAddPark(List *l, Park *p);
-void listAddRecord(List *l, Record *r);
-Park *listGetPark(List *l, char *name);
+void listAddRecord(Slab *s, List *l, Record *r);
 void removePark(Memory *m, int parkId);
-void addRecord(HashTable *h, Record *r1);
-List *getListPlates(HashTable *h, char *plates);
-Record *getLastRecord(HashTable *h, char *plates);
+void hashReserve(HashTable *h, int count);
+void addRecord(Memory *m, Record *r1);
+void compactRecords(Memory *m, Park *p);
+HashNode *getHashNode(HashTable *h, Plate plate);
+void hashPrefetch(HashTable *h, Plate plate, int level);
+Park *getParkById(Memory *m, int id);
+List *getListPlates(HashTable *h, Plate plate);
+Node *seekRecords(HashNode *n, int day);
+Record *getLastRecord(HashTable *h, Plate plate);
+void lockTable(Memory *m);
+void unlockTable(Memory *m);
+void lockVehicle(Memory *m, Plate plate);
+void unlockVehicle(Memory *m, Plate plate);
 
 /*aux_functions.c*/
-List *calculateSums(List *records);
+List *calculateSums(Park *p);
 int timeToInt(char *time);
 int dateToInt(char *date);
 void intToTime(int t, char *time);
 void intToDate(int d, char *date);
-int checkDates(Memory *m, char *d2, char *t2);
+Stamp parseStamp(char *date, char *time);
+int checkStamp(Memory *m, Stamp stamp);
 void readLine(char buffer[]);
 void initializeSystem(Memory *m);
+void expectRecords(Memory *m, long records);
 int checkPlates(char *l);
-void calculatePrice(Record *v);
-void updateMemoryTime(Memory *m, int d, int t);
+Plate encodePlate(char *l);
+void decodePlate(Plate plate, char *l);
+int checkPlateCode(Plate plate);
+Cents toCents(float value);
+Cents calculatePrice(Park *p, Record *v);
+int updateMemoryTime(Memory *m, Stamp now);
+int dateFromParts(int day, int month, int year);
 int checkDateFormat(char *date);
+int checkTimeFormat(char *time);
 void initializeHashTable(HashTable *h);
 
+/*names.c*/
+Park *getPark(Memory *m, char *name);
+void namesAddPark(Memory *m, Park *p);
+void namesRemovePark(Memory *m, Park *p);
+
+/*billing.c*/
+Revenue *revenueNew();
+void revenueAdd(Revenue *r, int day, Cents paid);
+Cents revenueRange(Revenue *r, int from, int to);
+List *calculateNetworkSums(List *parks, Cents *subtotals);
+void freeRevenue(Revenue *r);
+Bills *billsNew();
+void billsFreeze(Park *p, int day);
+void billsClose(Memory *m);
+void billsRebuild(Park *p);
+void billsPrint(Park *p, FILE *out);
+void billsPrintDate(Park *p, int day, FILE *out);
+void freeBills(Bills *b);
+
+/*ranking.c*/
+void topKInit(TopK *t, int kind);
+void tallyInit(Tally *t, Plate plate, int parkId);
+void rankExit(Memory *m, Park *p, Record *r, Cents paid);
+void rankRemovePark(HashNode *n, int parkId);
+void rankRebuild(Memory *m);
+int topKSorted(TopK *t, Tally **out);
+
+/*occupancy.c*/
+History *historyNew();
+void historyAdd(History *h, Stamp stamp, int occupancy);
+int historyAt(History *h, Stamp stamp);
+int historyPeak(History *h, int from, int to);
+void freeHistory(History *h);
+
+/*stats.c*/
+Stats *statsNew();
+void statsEnter(Stats *s, Stamp now, int occupancy);
+void statsExit(Stats *s, Record *r, int occupancy);
+Stamp statsQuantile(Stats *s, int percent);
+void statsPrint(Park *p, FILE *out);
+void statsPrintDays(Park *p, FILE *out);
+void freeStats(Stats *s);
+
+/*wheel.c*/
+Wheel *wheelNew(Stamp threshold);
+void wheelArm(Memory *m, HashNode *n, Record *r);
+void wheelCancel(Memory *m, HashNode *n);
+void wheelAdvance(Memory *m, Stamp now);
+void wheelPrint(Memory *m, Park *p);
+void freeWheel(Wheel *w);
+
+/*summary.c*/
+void reject(Memory *m, const char *format, ...);
+void countCommand(Memory *m, char command);
+void mergeSummary(Memory *m, Summary *s);
+void printSummary(Memory *m);
+
+/*slab.c*/
+void slabInit(Slab *s, int itemSize);
+void slabReserve(Slab *s, long items);
+void *slabAlloc(Slab *s);
+void slabFree(Slab *s, void *item);
+void slabDestroy(Slab *s);
+void *hugeMap(size_t size);
+void *hugeAlloc(size_t size);
+void hugeUnmap(void *start, size_t size);
+
 /*memory_free.c*/
 void cleanUp(Memory *m);
 void freeDateSumList(List *l);
-void freePark(Park *p);
+void freePark(Slab *nodes, Park *p);
+void freeTallies(HashNode *n);
 #endif
\ No newline at end of file
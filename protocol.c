@@ -0,0 +1,414 @@
+/**
+ * @file protocol.c
+ * @brief Source file for the binary command protocol.
+ *
+ * This file contains the implementation of the binary format of commands 'e',
+ * 's', 'v' and 'f', selected with the option -b. Requests and responses are
+ * 16-byte frames, so parks are given by id, license plates are encoded and
+ * dates are Stamps, and the commands go straight into the validation and the
+ * changes shared with the text format, without any text being formatted or
+ * parsed. Every request gets a header frame with the same operation and a
+ * status, which may be followed by data frames:
+ *
+ * - 'e': `park`, `plate` and the entry in `a`. The header has the free spots
+ *   of the park in `a`.
+ * - 's': `park`, `plate` and the exit in `a`. The header has the entry in `a`
+ *   and the amount paid, in cents, in `b`, or status ST_OVERFLOW and no
+ *   amount if it does not fit in 32 bits, although the exit is recorded.
+ * - 'v': `plate`. The header has the number of records in `a`, each one in a
+ *   data frame, see `writeRecords`.
+ * - 'f': `park` and, in `a` and `b`, no days for the total of each day, see
+ *   `writeBills`, one day for its exits, see `writeBillsDate`, or the first
+ *   and last days of a range, for a single data frame with the first day in
+ *   `a` and the total of the range in `b`. The header has the number of data
+ *   frames in `a`, or status ST_OVERFLOW and no data frames if an amount
+ *   does not fit in 32 bits.
+ * - 'T': the length, in `a`, of a text command that follows the frame, such
+ *   as 'p' to add a park. Its output is discarded and the header only tells
+ *   whether it printed an error. A text longer than BUF_SIZE is skipped,
+ *   with status ST_INVALID_FRAME.
+ * - 'q': ends the program, without a response.
+ *
+ * Frames are FRAME_SIZE bytes, with every field little-endian whatever the
+ * byte order of the machine, see `packFrame`.
+ *
+ * Requests are read into a buffer of BUF_SIZE bytes and taken from it in
+ * windows of up to PREFETCH_WINDOW frames, and the entries of the vehicles
+ * of every 'e' and 's' in a window are prefetched, one level at a time,
+ * before the window is served in order.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "project.h"
+
+/**
+ * @brief Structure to hold the requests read and not yet served.
+ *
+ * Requests are read straight from the descriptor of the stream, so the bytes
+ * already read and not yet taken are the ones in `bytes`, and the stream
+ * must not have been read with stdio. A stream with no descriptor, such as
+ * one in memory, is read with `fread`.
+ *
+ * @param in The stream of the requests.
+ * @param fd The descriptor of the stream, or -1 if it has none.
+ * @param bytes The bytes read.
+ * @param start The first byte not yet taken.
+ * @param end The end of the bytes read.
+ */
+typedef struct {
+  FILE *in;
+  int fd;
+  uint8_t bytes[BUF_SIZE];
+  size_t start, end;
+} Requests;
+
+/**
+ * @brief Writes a number as little-endian bytes.
+ *
+ * @param bytes Where the bytes are written.
+ * @param value The number.
+ * @param count The number of bytes.
+ */
+static void putLittle(uint8_t *bytes, uint32_t value, int count) {
+  for (int i = 0; i < count; i++) {
+    bytes[i] = value >> (8 * i);
+  }
+}
+
+/**
+ * @brief Reads a number from little-endian bytes.
+ *
+ * @param bytes The bytes.
+ * @param count The number of bytes.
+ * @return Returns the number.
+ */
+static uint32_t getLittle(const uint8_t *bytes, int count) {
+  uint32_t value = 0;
+  for (int i = count - 1; i >= 0; i--) {
+    value = value << 8 | bytes[i];
+  }
+  return value;
+}
+
+/**
+ * @brief Packs a frame into the bytes sent: the operation, the status, the
+ * park, the plate, `a` and `b`, each little-endian.
+ *
+ * @param f A pointer to the frame.
+ * @param bytes Where the FRAME_SIZE bytes are written.
+ */
+void packFrame(Frame *f, uint8_t *bytes) {
+  bytes[0] = f->op;
+  bytes[1] = f->status;
+  putLittle(bytes + 2, f->park, 2);
+  putLittle(bytes + 4, f->plate, 4);
+  putLittle(bytes + 8, f->a, 4);
+  putLittle(bytes + 12, f->b, 4);
+}
+
+/**
+ * @brief Unpacks a frame packed by `packFrame`.
+ *
+ * @param bytes The FRAME_SIZE bytes of the frame.
+ * @param f A pointer to where the frame is stored.
+ */
+static void unpackFrame(const uint8_t *bytes, Frame *f) {
+  f->op = bytes[0];
+  f->status = bytes[1];
+  f->park = getLittle(bytes + 2, 2);
+  f->plate = getLittle(bytes + 4, 4);
+  f->a = getLittle(bytes + 8, 4);
+  f->b = getLittle(bytes + 12, 4);
+}
+
+/**
+ * @brief Reads a frame, packed as by `packFrame`.
+ *
+ * @param f A pointer to where the frame is stored.
+ * @param in The stream to read from.
+ * @return Returns 1 if a frame was read, or 0 at the end of the input.
+ */
+int readFrame(Frame *f, FILE *in) {
+  uint8_t bytes[FRAME_SIZE];
+  if (fread(bytes, 1, FRAME_SIZE, in) != FRAME_SIZE) {
+    return 0;
+  }
+  unpackFrame(bytes, f);
+  return 1;
+}
+
+/**
+ * @brief Reads more requests into their buffer, after the bytes not yet
+ * taken, which are first moved to its start.
+ *
+ * @param r A pointer to the requests.
+ * @param wait Whether to wait for the input, or only read what the
+ * descriptor already has.
+ * @return Returns 1 if bytes were read, or 0 at the end of the input or if
+ * there were none to read without waiting.
+ */
+static int readRequests(Requests *r, int wait) {
+  struct pollfd input = {r->fd, POLLIN, 0};
+  ssize_t count;
+  memmove(r->bytes, r->bytes + r->start, r->end - r->start);
+  r->end -= r->start;
+  r->start = 0;
+  if (r->fd < 0) {
+    count = fread(r->bytes + r->end, 1, BUF_SIZE - r->end, r->in);
+  } else if (!wait && poll(&input, 1, 0) != 1) {
+    return 0;
+  } else {
+    count = read(r->fd, r->bytes + r->end, BUF_SIZE - r->end);
+  }
+  if (count <= 0) {
+    return 0;
+  }
+  r->end += count;
+  return 1;
+}
+
+/**
+ * @brief Takes the bytes that follow a frame, such as the text of a 'T'
+ * frame, from the requests.
+ *
+ * @param r A pointer to the requests.
+ * @param bytes Where the bytes are copied, or NULL to drop them.
+ * @param length The number of bytes.
+ * @return Returns 1 if they were all taken, or 0 at the end of the input.
+ */
+static int takeBytes(Requests *r, char *bytes, uint32_t length) {
+  while (length > 0) {
+    size_t count = r->end - r->start;
+    if (count == 0 && !readRequests(r, 1)) {
+      return 0;
+    }
+    count = r->end - r->start < length ? r->end - r->start : length;
+    if (bytes) {
+      memcpy(bytes, r->bytes + r->start, count);
+      bytes += count;
+    }
+    r->start += count;
+    length -= count;
+  }
+  return 1;
+}
+
+/**
+ * @brief Checks whether an amount fits in a field of a frame.
+ *
+ * @param amount The amount, in cents.
+ * @return Returns 1 if it fits in 32 bits, or 0.
+ */
+int fitsFrame(Cents amount) { return amount >= 0 && amount <= UINT32_MAX; }
+
+/**
+ * @brief Executes a text command carried by a binary frame.
+ *
+ * The text is run by `parkCommand`. A text longer than BUF_SIZE is dropped,
+ * so that the frames after it are still read from their first byte.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param length The length of the text command.
+ * @param in A pointer to the requests the text command is taken from.
+ * @return Returns ST_OK, ST_REJECTED if the command printed an error, or
+ * ST_INVALID_FRAME if the text is empty, too long or cut short.
+ */
+static int serveText(Memory *m, uint32_t length, Requests *in) {
+  char buffer[BUF_SIZE + 1];
+  if (length > BUF_SIZE) {
+    takeBytes(in, NULL, length);
+    return ST_INVALID_FRAME;
+  }
+  if (length == 0 || !takeBytes(in, buffer, length)) {
+    return ST_INVALID_FRAME;
+  }
+  buffer[length] = '\0';
+  return parkCommand(m, buffer);
+}
+
+/**
+ * @brief Serves a request of command 'f'.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param req A pointer to the request.
+ * @param res A pointer to the header frame of the response.
+ * @param out The stream to write to.
+ */
+static void serveBills(Memory *m, Frame *req, Frame *res, FILE *out) {
+  int from = req->a, to = req->b;
+  Cents total;
+  if (from == 0) {
+    writeBills(m, req->park, res, out);
+  } else if (to == 0) {
+    writeBillsDate(m, req->park, from, res, out);
+  } else {
+    res->status = parkBillsRange(m, req->park, from, to, &total);
+    if (res->status == ST_OK && !fitsFrame(total)) {
+      res->status = ST_OVERFLOW;
+    }
+    res->a = res->status == ST_OK;
+    writeFrame(res, out);
+    if (res->status == ST_OK) {
+      Frame range = {CM_GET_BILLS, ST_OK, req->park, 0, from, total};
+      writeFrame(&range, out);
+    }
+  }
+}
+
+/**
+ * @brief Serves a request frame.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param req A pointer to the request.
+ * @param in A pointer to the requests the request was taken from.
+ * @param out The stream to write to.
+ */
+static void serveFrame(Memory *m, Frame *req, Requests *in, FILE *out) {
+  Frame res = {req->op, ST_OK, req->park, req->plate, 0, 0};
+  Park *p = getParkById(m, req->park);
+  Record *r;
+  int spots;
+  switch (req->op) {
+    case CM_ADD_VEHICLE:
+      countCommand(m, req->op);
+      res.status = vehicleEnter(m, p, req->plate, req->a, &spots);
+      if (res.status == ST_OK) {
+        res.a = spots;
+      }
+      break;
+    case CM_EXIT_VEHICLE:
+      countCommand(m, req->op);
+      res.status = vehicleExit(m, p, req->plate, req->a, &r);
+      if (res.status == ST_OK) {
+        Cents price = calculatePrice(p, r);
+        res.a = r->entry;
+        if (fitsFrame(price)) {
+          res.b = price;
+        } else {
+          res.status = ST_OVERFLOW;
+        }
+      }
+      break;
+    case CM_PRINT_VEHICLES:
+      countCommand(m, req->op);
+      if (!checkPlateCode(req->plate)) {
+        res.status = ST_INVALID_LICENSE;
+      } else if (!writeRecords(m, req->plate, &res, out)) {
+        res.status = ST_NO_ENTRIES;
+      } else {
+        return;
+      }
+      break;
+    case CM_GET_BILLS:
+      countCommand(m, req->op);
+      serveBills(m, req, &res, out);
+      return;
+    case CM_TEXT:
+      res.status = serveText(m, req->a, in);
+      break;
+    default:
+      res.status = ST_INVALID_FRAME;
+  }
+  writeFrame(&res, out);
+}
+
+/**
+ * @brief Makes sure the buffer of the requests holds a whole frame.
+ *
+ * @param r A pointer to the requests.
+ * @param wait Whether to wait for the input.
+ * @return Returns 1 if it holds a frame, or 0 at the end of the input or if
+ * the frame has not all arrived and is not waited for.
+ */
+static int holdsFrame(Requests *r, int wait) {
+  while (r->end - r->start < FRAME_SIZE) {
+    if (!readRequests(r, wait)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief Takes a window of request frames.
+ *
+ * After the first frame, frames are only taken while the input has more,
+ * already in the buffer or still in the descriptor, so that a client
+ * waiting for a response is never waited on. A 'T' or 'q' frame ends the
+ * window, since what follows it is not a frame.
+ *
+ * @param r A pointer to the requests.
+ * @param window The array where the frames are stored.
+ * @return Returns the number of frames taken, 0 at the end of the input.
+ */
+static int readWindow(Requests *r, Frame *window) {
+  int count = 0;
+  while (count < PREFETCH_WINDOW && holdsFrame(r, count == 0)) {
+    unpackFrame(r->bytes + r->start, &window[count]);
+    r->start += FRAME_SIZE;
+    uint8_t op = window[count++].op;
+    if (op == CM_TEXT || op == CM_EXIT) {
+      break;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Prefetches the entries of the vehicles of a window of requests.
+ *
+ * Each level is prefetched for every 'e' and 's' of the window before the
+ * next one, so the cache misses of the requests overlap instead of being
+ * waited on one after the other when they are served.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param window The requests.
+ * @param count The number of requests.
+ */
+static void prefetchWindow(Memory *m, Frame *window, int count) {
+  for (int level = 0; level < PREFETCH_LEVELS; level++) {
+    for (int i = 0; i < count; i++) {
+      if (window[i].op == CM_ADD_VEHICLE || window[i].op == CM_EXIT_VEHICLE) {
+        hashPrefetch(m->cars, window[i].plate, level);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reads request frames and writes the responses until the end of the
+ * input or a 'q' request.
+ *
+ * Responses are flushed after each request, so that a client waiting for
+ * them is answered, unless the output is a regular file.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param in The stream to read the requests from.
+ * @param out The stream to write the responses to.
+ */
+void serveFrames(Memory *m, FILE *in, FILE *out) {
+  Requests r;
+  struct stat info;
+  Frame window[PREFETCH_WINDOW];
+  int flush = fstat(fileno(out), &info) != 0 || !S_ISREG(info.st_mode);
+  int count, stop = 0;
+  r.in = in;
+  r.fd = fileno(in);
+  r.start = r.end = 0;
+  while (!stop && (count = readWindow(&r, window)) > 0) {
+    prefetchWindow(m, window, count);
+    for (int i = 0; i < count && !(stop = window[i].op == CM_EXIT); i++) {
+      serveFrame(m, &window[i], &r, out);
+      if (flush) {
+        fflush(out);
+      }
+    }
+  }
+  fflush(out);
+}
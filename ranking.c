@@ -0,0 +1,251 @@
+/**
+ * @file ranking.c
+ * @brief Source file for the top vehicle rankings.
+ *
+ * This file contains the implementation of the rankings of the vehicles that
+ * pay the most and that visit the parks the most, for the whole network and
+ * for each park. Every vehicle keeps running totals that are updated when it
+ * leaves a park, and each ranking is a bounded min-heap with the TOP_K largest
+ * totals. Since totals only grow, a vehicle enters a ranking when it overtakes
+ * the smallest vehicle in it, so the rankings are exact and never require a
+ * walk over the hash table, except when a park is removed.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdlib.h>
+
+#include "project.h"
+
+/**
+ * @brief Initializes an empty ranking.
+ *
+ * @param t A pointer to the ranking to be initialized.
+ * @param kind The ranking, RANK_SPEND or RANK_VISITS.
+ */
+void topKInit(TopK *t, int kind) {
+  t->size = 0;
+  t->kind = kind;
+}
+
+/**
+ * @brief Initializes the running totals of a vehicle.
+ *
+ * @param t A pointer to the tally to be initialized.
+ * @param plate The encoded license plate of the vehicle.
+ * @param parkId The id of the park, or 0 for the network totals.
+ */
+void tallyInit(Tally *t, Plate plate, int parkId) {
+  t->plate = plate;
+  t->parkId = parkId;
+  t->visits = 0;
+  t->paid = 0;
+  t->pos[RANK_SPEND] = -1;
+  t->pos[RANK_VISITS] = -1;
+  t->next = NULL;
+}
+
+/**
+ * @brief Compares two tallies according to a ranking.
+ *
+ * Tallies are compared by the amount paid or the number of visits, then by
+ * the other value and finally by license plate, so that the order is total.
+ *
+ * @param kind The ranking, RANK_SPEND or RANK_VISITS.
+ * @param a A pointer to the first tally.
+ * @param b A pointer to the second tally.
+ * @return Returns a positive integer if the first tally ranks higher than the
+ * second, a negative integer if it ranks lower, and zero if they are the same.
+ */
+static int compareTallies(int kind, Tally *a, Tally *b) {
+  if (a->visits != b->visits && (kind == RANK_VISITS || a->paid == b->paid)) {
+    return a->visits > b->visits ? 1 : -1;
+  } else if (a->paid != b->paid) {
+    return a->paid > b->paid ? 1 : -1;
+  }
+  return a->plate < b->plate ? 1 : (a->plate > b->plate ? -1 : 0);
+}
+
+/**
+ * @brief Places a tally at a position of a ranking heap.
+ *
+ * @param t A pointer to the ranking.
+ * @param i The position in the heap.
+ * @param x A pointer to the tally.
+ */
+static void topKSet(TopK *t, int i, Tally *x) {
+  t->heap[i] = x;
+  x->pos[t->kind] = i;
+}
+
+/**
+ * @brief Moves a tally towards the root of the heap while it ranks lower than
+ * its parent.
+ *
+ * @param t A pointer to the ranking.
+ * @param i The position of the tally in the heap.
+ */
+static void siftUp(TopK *t, int i) {
+  Tally *x = t->heap[i];
+  while (i > 0 && compareTallies(t->kind, x, t->heap[(i - 1) / 2]) < 0) {
+    topKSet(t, i, t->heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
+  }
+  topKSet(t, i, x);
+}
+
+/**
+ * @brief Moves a tally towards the leaves of the heap while it ranks higher
+ * than one of its children.
+ *
+ * @param t A pointer to the ranking.
+ * @param i The position of the tally in the heap.
+ */
+static void siftDown(TopK *t, int i) {
+  Tally *x = t->heap[i];
+  int child;
+  while ((child = 2 * i + 1) < t->size) {
+    if (child + 1 < t->size &&
+        compareTallies(t->kind, t->heap[child + 1], t->heap[child]) < 0) {
+      child++;
+    }
+    if (compareTallies(t->kind, t->heap[child], x) >= 0) {
+      break;
+    }
+    topKSet(t, i, t->heap[child]);
+    i = child;
+  }
+  topKSet(t, i, x);
+}
+
+/**
+ * @brief Updates a ranking after the totals of a vehicle have grown.
+ *
+ * If the tally is already in the ranking, it is moved down the heap. If not,
+ * it is inserted when the ranking is not full, or it replaces the smallest
+ * tally in the ranking if it now ranks higher than it.
+ *
+ * @param t A pointer to the ranking.
+ * @param x A pointer to the tally that has grown.
+ */
+static void topKUpdate(TopK *t, Tally *x) {
+  if (x->pos[t->kind] >= 0) {
+    siftDown(t, x->pos[t->kind]);
+  } else if (t->size < TOP_K) {
+    t->heap[t->size] = x;
+    siftUp(t, t->size++);
+  } else if (compareTallies(t->kind, x, t->heap[0]) > 0) {
+    t->heap[0]->pos[t->kind] = -1;
+    topKSet(t, 0, x);
+    siftDown(t, 0);
+  }
+}
+
+/**
+ * @brief Updates the totals and rankings of a vehicle that has left a park.
+ *
+ * This function adds the visit and the amount paid in the record to the
+ * network totals and to the park totals of the vehicle, creating the latter
+ * on its first exit from the park, and updates the corresponding rankings.
+ * The caller holds the locks of the vehicle and of the park. The network
+ * totals are updated holding the network lock with the network rankings,
+ * since their heaps compare the totals of vehicles of other gates.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param p A pointer to the park the vehicle has left.
+ * @param r A pointer to the record of the exit.
+ * @param paid The amount paid on the exit, in cents.
+ */
+void rankExit(Memory *m, Park *p, Record *r, Cents paid) {
+  HashNode *n = getHashNode(m->cars, r->plate);
+  Tally *t = n->parks;
+  while (t && t->parkId != p->id) {
+    t = t->next;
+  }
+  if (!t) {
+    t = malloc(sizeof(Tally));
+    tallyInit(t, r->plate, p->id);
+    t->next = n->parks;
+    n->parks = t;
+  }
+  t->visits++;
+  t->paid += paid;
+  for (int kind = RANK_SPEND; kind <= RANK_VISITS; kind++) {
+    topKUpdate(&p->top[kind], t);
+  }
+  pthread_mutex_lock(&m->lock);
+  n->total.visits++;
+  n->total.paid += paid;
+  for (int kind = RANK_SPEND; kind <= RANK_VISITS; kind++) {
+    topKUpdate(&m->top[kind], &n->total);
+  }
+  pthread_mutex_unlock(&m->lock);
+}
+
+/**
+ * @brief Removes the totals of a vehicle in a park that is being removed.
+ *
+ * The park totals are subtracted from the network totals of the vehicle, which
+ * leaves the network rankings stale until `rankRebuild` is called.
+ *
+ * @param n A pointer to the hash table node of the vehicle.
+ * @param parkId The id of the park being removed.
+ */
+void rankRemovePark(HashNode *n, int parkId) {
+  Tally **t = &n->parks;
+  while (*t) {
+    if ((*t)->parkId == parkId) {
+      Tally *old = *t;
+      n->total.visits -= old->visits;
+      n->total.paid -= old->paid;
+      *t = old->next;
+      free(old);
+      return;
+    }
+    t = &(*t)->next;
+  }
+}
+
+/**
+ * @brief Rebuilds the network rankings from the totals of every vehicle.
+ *
+ * This function is called after a park is removed, since the network totals
+ * of its vehicles have decreased.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+void rankRebuild(Memory *m) {
+  for (int kind = RANK_SPEND; kind <= RANK_VISITS; kind++) {
+    m->top[kind].size = 0;
+  }
+  for (int i = 0; i < m->cars->size; i++) {
+    HashNode *n = m->cars->plate[i];
+    if (n) {
+      n->total.pos[RANK_SPEND] = -1;
+      n->total.pos[RANK_VISITS] = -1;
+      if (n->total.visits > 0) {
+        topKUpdate(&m->top[RANK_SPEND], &n->total);
+        topKUpdate(&m->top[RANK_VISITS], &n->total);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Copies a ranking into an array, from the highest to the lowest.
+ *
+ * @param t A pointer to the ranking.
+ * @param out An array of at least TOP_K positions for the tallies.
+ * @return Returns the number of tallies in the ranking.
+ */
+int topKSorted(TopK *t, Tally **out) {
+  Tally *x;
+  int j;
+  for (int i = 0; i < t->size; i++) {
+    x = t->heap[i];
+    for (j = i; j > 0 && compareTallies(t->kind, out[j - 1], x) < 0; j--) {
+      out[j] = out[j - 1];
+    }
+    out[j] = x;
+  }
+  return t->size;
+}
@@ -0,0 +1,435 @@
+/**
+ * @file server.c
+ * @brief Source file for the server mode.
+ *
+ * This file contains the implementation of the server selected with the
+ * option -s, which listens on a Unix domain socket instead of reading stdin.
+ * Each client sends text commands as they would be written to stdin, and gets
+ * back only the output of its own commands. The connections are multiplexed
+ * with epoll: every loop reads what the ready clients sent and then executes
+ * their complete lines, in the order they arrived, on the same Memory. The
+ * output of all the commands of a client in a loop is gathered in a single
+ * buffer and sent at once. While a client has output waiting to be sent, its
+ * input is not read. The command 'q' ends the connection of its client, and
+ * the server runs until it gets SIGINT or SIGTERM. With reader threads, the
+ * queries 'v', 'f' and 'p' with no arguments are run by them on a snapshot,
+ * see snapshot.c, while the loop goes on with the other clients. A client
+ * that hangs up while its input is not being read is closed at once, or, if
+ * a reader thread runs its query, once the query is answered.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "project.h"
+
+/*Set by SIGINT and SIGTERM to stop the server*/
+static volatile sig_atomic_t stopping = 0;
+
+/**
+ * @brief Handles the signals that stop the server.
+ *
+ * @param signal The signal received.
+ */
+static void stopServer(int signal) {
+  (void)signal;
+  stopping = 1;
+}
+
+/**
+ * @brief Opens the listening socket of the server.
+ *
+ * @param s A pointer to the server.
+ * @param path The path of the socket.
+ * @return Returns 1, or 0 if the socket cannot be opened.
+ */
+static int openServer(Server *s, const char *path) {
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    errno = ENAMETOOLONG;
+    return 0;
+  }
+  strcpy(address.sun_path, path);
+  unlink(path);
+  s->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  s->epoll = epoll_create1(0);
+  return s->listener >= 0 && s->epoll >= 0 &&
+         fcntl(s->listener, F_SETFL, O_NONBLOCK) == 0 &&
+         bind(s->listener, (struct sockaddr *)&address, sizeof(address)) ==
+             0 &&
+         listen(s->listener, SOMAXCONN) == 0 &&
+         epoll_ctl(s->epoll, EPOLL_CTL_ADD, s->listener, &event) == 0;
+}
+
+/**
+ * @brief Accepts the pending connections.
+ *
+ * @param s A pointer to the server.
+ */
+static void acceptClients(Server *s) {
+  struct epoll_event event = {.events = EPOLLIN};
+  Client *c;
+  int fd;
+  while ((fd = accept(s->listener, NULL, NULL)) >= 0) {
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    if (s->count == s->capacity) {
+      s->capacity = s->capacity ? s->capacity * 2 : 16;
+      s->clients = realloc(s->clients, s->capacity * sizeof(Client *));
+    }
+    c = calloc(1, sizeof(Client));
+    c->fd = fd;
+    c->index = s->count;
+    c->events = EPOLLIN;
+    s->clients[s->count++] = c;
+    event.data.ptr = c;
+    epoll_ctl(s->epoll, EPOLL_CTL_ADD, fd, &event);
+  }
+}
+
+/**
+ * @brief Closes the connection of a client and frees it.
+ *
+ * @param s A pointer to the server.
+ * @param c A pointer to the client.
+ */
+static void closeClient(Server *s, Client *c) {
+  epoll_ctl(s->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+  close(c->fd);
+  s->clients[c->index] = s->clients[--s->count];
+  s->clients[c->index]->index = c->index;
+  free(c->out);
+  free(c);
+}
+
+/**
+ * @brief Reads what a client sent, as much as fits in its input.
+ *
+ * A line longer than the input ends the connection, as does the end of the
+ * input or an error.
+ *
+ * @param c A pointer to the client.
+ */
+static void readClient(Client *c) {
+  ssize_t n;
+  if (c->inLength == BUF_SIZE) {
+    c->inLength = 0;
+    c->done = 1;
+    return;
+  }
+  n = read(c->fd, c->in + c->inLength, BUF_SIZE - c->inLength);
+  if (n > 0) {
+    c->inLength += n;
+  } else if (n == 0 || errno != EAGAIN) {
+    c->done = 1;
+  }
+}
+
+/**
+ * @brief Ends the connection of a client that hung up or failed while its
+ * input was not being read, dropping its input and output.
+ *
+ * The socket is taken out of epoll, since epoll reports a hang up even when
+ * no events are waited for, so a client waiting for a reader thread would
+ * otherwise be reported in every loop until its query is answered.
+ *
+ * @param s A pointer to the server.
+ * @param c A pointer to the client.
+ */
+static void hangUp(Server *s, Client *c) {
+  epoll_ctl(s->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+  c->events = 0;
+  c->inLength = 0;
+  c->outLength = c->outSent = 0;
+  c->done = 1;
+}
+
+/**
+ * @brief Checks whether a line is a query that a reader thread can run.
+ *
+ * @param line The line.
+ * @return Returns 1 for commands 'v', 'f' and 'p' with no arguments, or 0.
+ */
+static int isQuery(char *line) {
+  return line[0] == CM_PRINT_VEHICLES || line[0] == CM_GET_BILLS ||
+         (line[0] == CM_ADD_PARK && line[1] == '\0');
+}
+
+/**
+ * @brief Checks whether a line is a change that the replicas must replay.
+ *
+ * @param line The line.
+ * @return Returns 1 for commands 'e', 's', 'r', 'i' and 'p' with arguments,
+ * or 0.
+ */
+static int isChange(char *line) {
+  return line[0] == CM_ADD_VEHICLE || line[0] == CM_EXIT_VEHICLE ||
+         line[0] == CM_REMOVE_PARK || line[0] == CM_IMPORT ||
+         (line[0] == CM_ADD_PARK && line[1] != '\0');
+}
+
+/**
+ * @brief Executes a line of a client.
+ *
+ * With reader threads, queries are queued for them, and the client waits for
+ * the answer before its next line is executed. Changes are added to the log
+ * of the replicas after being applied, imports with the rows they imported.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s A pointer to the server.
+ * @param c A pointer to the client.
+ * @param line The line, without the newline.
+ */
+static void runLine(Memory *m, Server *s, Client *c, char *line) {
+  if (line[0] == CM_EXIT) {
+    c->done = 1;
+  } else if (s->snapshots && isQuery(line)) {
+    Query *q = calloc(1, sizeof(Query));
+    countCommand(m, line[0]);
+    q->client = c;
+    q->line = strdup(line);
+    q->version = c->version;
+    c->waiting = 1;
+    snapshotsQuery(s->snapshots, q);
+  } else {
+    char *rows = NULL;
+    size_t size = 0;
+    if (s->snapshots && line[0] == CM_IMPORT) {
+      m->imported = open_memstream(&rows, &size);
+    }
+    execute(m, line[0], line + 1);
+    if (m->imported) {
+      fclose(m->imported);
+      m->imported = NULL;
+    }
+    if (s->snapshots && isChange(line)) {
+      c->version = snapshotsLog(s->snapshots, line, rows, size);
+    }
+  }
+}
+
+/**
+ * @brief Adds text to the output of a client.
+ *
+ * @param c A pointer to the client.
+ * @param text The text.
+ * @param length The number of characters of the text.
+ */
+static void addOutput(Client *c, char *text, size_t length) {
+  if (length > 0) {
+    c->out = realloc(c->out, c->outLength + length);
+    memcpy(c->out + c->outLength, text, length);
+    c->outLength += length;
+  }
+}
+
+/**
+ * @brief Executes the complete lines of a client, and the incomplete last one
+ * if the client ended its input, and adds their output to its output.
+ *
+ * The output is caught by pointing the output of the Memory to a memory
+ * stream while the lines are executed. The lines stop at a query left to a
+ * reader thread, and go on once it is answered.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s A pointer to the server.
+ * @param c A pointer to the client.
+ */
+static void runClient(Memory *m, Server *s, Client *c) {
+  FILE *saved = m->out;
+  char *text, *end;
+  size_t length;
+  int start = 0;
+  c->in[c->inLength] = '\0';
+  m->out = open_memstream(&text, &length);
+  while (start < c->inLength && !c->waiting) {
+    end = memchr(c->in + start, '\n', c->inLength - start);
+    if (!end && !c->done) {
+      break;
+    }
+    end = end ? end : c->in + c->inLength;
+    *end = '\0';
+    runLine(m, s, c, c->in + start);
+    start = end - c->in + 1;
+    if (c->done) {
+      start = c->inLength;
+    }
+  }
+  fclose(m->out);
+  m->out = saved;
+  c->inLength -= start;
+  memmove(c->in, c->in + start, c->inLength);
+  addOutput(c, text, length);
+  free(text);
+}
+
+/**
+ * @brief Sends as much of the output of a client as the socket takes.
+ *
+ * If the connection fails, the output is dropped and the client is done.
+ *
+ * @param c A pointer to the client.
+ */
+static void flushClient(Client *c) {
+  ssize_t n;
+  while (c->outSent < c->outLength) {
+    n = send(c->fd, c->out + c->outSent, c->outLength - c->outSent,
+             MSG_NOSIGNAL);
+    if (n < 0 && errno == EAGAIN) {
+      return;
+    } else if (n < 0) {
+      c->outSent = c->outLength;
+      c->done = 1;
+    } else {
+      c->outSent += n;
+    }
+  }
+  c->outLength = c->outSent = 0;
+}
+
+/**
+ * @brief Runs, sends the output of, and maybe closes a ready client.
+ *
+ * The client waits to write while it has output to send, waits for nothing
+ * while a reader thread runs its query, and waits to read otherwise. It is
+ * closed when it is done, has no query running and all its output was sent.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s A pointer to the server.
+ * @param c A pointer to the client.
+ */
+static void serveClient(Memory *m, Server *s, Client *c) {
+  struct epoll_event event = {.data.ptr = c};
+  if (!c->waiting) {
+    runClient(m, s, c);
+  }
+  flushClient(c);
+  event.events = c->outLength > 0 ? EPOLLOUT : c->waiting ? 0 : EPOLLIN;
+  if (c->done && !c->waiting && c->outLength == 0) {
+    closeClient(s, c);
+  } else if (c->events != event.events) {
+    c->events = event.events;
+    epoll_ctl(s->epoll, EPOLL_CTL_MOD, c->fd, &event);
+  }
+}
+
+/**
+ * @brief Adds a client to the clients to be served in this loop.
+ *
+ * @param c A pointer to the client.
+ * @param ready A pointer to the first client to be served.
+ */
+static void setReady(Client *c, Client **ready) {
+  if (!c->ready) {
+    c->ready = 1;
+    c->nextReady = *ready;
+    *ready = c;
+  }
+}
+
+/**
+ * @brief Adds the answers of the reader threads to the output of their
+ * clients, which are then served again.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s A pointer to the server.
+ * @param ready A pointer to the first client to be served.
+ */
+static void takeAnswers(Memory *m, Server *s, Client **ready) {
+  Query *q = snapshotsAnswered(s->snapshots);
+  while (q) {
+    Query *next = q->next;
+    addOutput(q->client, q->text, q->length);
+    mergeSummary(m, &q->summary);
+    q->client->waiting = 0;
+    setReady(q->client, ready);
+    free(q->line);
+    free(q->text);
+    free(q);
+    q = next;
+  }
+}
+
+/**
+ * @brief Serves clients on a Unix domain socket until SIGINT or SIGTERM.
+ *
+ * Each loop first accepts the new connections, reads the clients that sent
+ * something and takes the answers of the reader threads, and then executes
+ * and answers the clients, so the commands that arrived together are
+ * executed in a single batch.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param path The path of the socket, which is removed at the end.
+ * @param readers The number of reader threads, or 0 to run the queries in
+ * the loop.
+ * @return Returns 1, or 0 after printing an error if the socket cannot be
+ * opened.
+ */
+int serveSocket(Memory *m, const char *path, int readers) {
+  struct epoll_event events[SERVER_EVENTS];
+  struct sigaction action = {.sa_handler = stopServer};
+  Server s = {-1, -1, NULL, 0, 0, NULL};
+  Client *ready;
+  int n;
+  if (!openServer(&s, path)) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    close(s.listener);
+    close(s.epoll);
+    return 0;
+  }
+  if (readers > 0) {
+    struct epoll_event event = {.events = EPOLLIN};
+    s.snapshots = snapshotsStart(m, readers);
+    event.data.ptr = s.snapshots;
+    epoll_ctl(s.epoll, EPOLL_CTL_ADD, s.snapshots->notify, &event);
+  }
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  while (!stopping) {
+    if ((n = epoll_wait(s.epoll, events, SERVER_EVENTS, -1)) < 0) {
+      continue;
+    }
+    ready = NULL;
+    for (int i = 0; i < n; i++) {
+      Client *c = events[i].data.ptr;
+      if (!c) {
+        acceptClients(&s);
+      } else if ((void *)c == s.snapshots) {
+        takeAnswers(m, &s, &ready);
+      } else {
+        if (c->events & EPOLLIN) {
+          readClient(c);
+        } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+          hangUp(&s, c);
+        }
+        setReady(c, &ready);
+      }
+    }
+    while (ready) {
+      Client *next = ready->nextReady;
+      ready->ready = 0;
+      serveClient(m, &s, ready);
+      ready = next;
+    }
+  }
+  if (s.snapshots) {
+    snapshotsStop(s.snapshots);
+  }
+  while (s.count > 0) {
+    closeClient(&s, s.clients[0]);
+  }
+  free(s.clients);
+  close(s.listener);
+  close(s.epoll);
+  unlink(path);
+  return 1;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file slab.c
+ * @brief Source file for the slab allocator of fixed-size items.
+ *
+ * This file contains the implementation of a simple allocator for items that
+ * all have the same size, such as records. Items are carved out of large
+ * blocks, so allocating one is a pointer bump instead of a call to malloc, and
+ * freed items are kept in a free list to be reused. Space for many items can
+ * be reserved at once, so a bulk load allocates them from a single block.
+ * Allocating and freeing take a spin lock, held for a few instructions, so
+ * entries and exits at many gates at once can share the slabs.
+ *
+ * Blocks are anonymous mappings aligned to huge pages, at least one huge page
+ * long and each as large as all the previous ones together, so that a large
+ * history lives in a few blocks that take few TLB entries to walk.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "project.h"
+
+/**
+ * @brief Rounds a size up to whole huge pages.
+ *
+ * @param size The size.
+ * @return Returns the size rounded up.
+ */
+static size_t hugeSize(size_t size) {
+  return (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+/**
+ * @brief Maps zeroed memory for a large array.
+ *
+ * Sizes smaller than a huge page are mapped as they are. Larger sizes are
+ * rounded up to whole huge pages, which are taken from the huge pages
+ * reserved by the system if there are enough, or else aligned to a huge page
+ * and advised to be backed by transparent huge pages.
+ *
+ * @param size The size of the array.
+ * @return Returns a pointer to the array, to be freed with `hugeUnmap`, or
+ * NULL if it cannot be mapped.
+ */
+void *hugeMap(size_t size) {
+  int protection = PROT_READ | PROT_WRITE, flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  char *start;
+  size_t head;
+  if (size < HUGE_PAGE_SIZE) {
+    start = mmap(NULL, size, protection, flags, -1, 0);
+    return start == MAP_FAILED ? NULL : start;
+  }
+  size = hugeSize(size);
+  start = mmap(NULL, size, protection, flags | MAP_HUGETLB, -1, 0);
+  if (start != MAP_FAILED) {
+    return start;
+  }
+  start = mmap(NULL, size + HUGE_PAGE_SIZE, protection, flags, -1, 0);
+  if (start == MAP_FAILED) {
+    return NULL;
+  }
+  head = HUGE_PAGE_SIZE - (uintptr_t)start % HUGE_PAGE_SIZE;
+  munmap(start, head);
+  if (head < HUGE_PAGE_SIZE) {
+    munmap(start + head + size, HUGE_PAGE_SIZE - head);
+  }
+  madvise(start + head, size, MADV_HUGEPAGE);
+  return start + head;
+}
+
+/**
+ * @brief Maps zeroed memory for a large array that the program cannot go
+ * on without, see `hugeMap`.
+ *
+ * If the array cannot be mapped, an error is printed and the program ends.
+ *
+ * @param size The size of the array.
+ * @return Returns a pointer to the array, to be freed with `hugeUnmap`.
+ */
+void *hugeAlloc(size_t size) {
+  void *start = hugeMap(size);
+  if (!start) {
+    fprintf(stderr, "cannot map %zu bytes\n", size);
+    exit(1);
+  }
+  return start;
+}
+
+/**
+ * @brief Unmaps an array mapped by `hugeMap`.
+ *
+ * @param start A pointer to the array.
+ * @param size The size it was mapped with.
+ */
+void hugeUnmap(void *start, size_t size) {
+  munmap(start, size < HUGE_PAGE_SIZE ? size : hugeSize(size));
+}
+
+/**
+ * @brief Initializes an empty slab.
+ *
+ * @param s A pointer to the slab to be initialized.
+ * @param itemSize The size of each item, at least the size of a pointer.
+ */
+void slabInit(Slab *s, int itemSize) {
+  s->free = NULL;
+  s->next = NULL;
+  s->end = NULL;
+  s->blocks = NULL;
+  s->sizes = NULL;
+  s->mapped = 0;
+  s->blockCount = 0;
+  s->blockCapacity = 0;
+  s->itemSize = itemSize;
+  atomic_flag_clear(&s->lock);
+}
+
+/**
+ * @brief Takes the spin lock of a slab.
+ *
+ * @param s A pointer to the slab.
+ */
+static void slabLock(Slab *s) {
+  while (atomic_flag_test_and_set_explicit(&s->lock, memory_order_acquire)) {
+    sched_yield();
+  }
+}
+
+/**
+ * @brief Releases the spin lock of a slab.
+ *
+ * @param s A pointer to the slab.
+ */
+static void slabUnlock(Slab *s) {
+  atomic_flag_clear_explicit(&s->lock, memory_order_release);
+}
+
+/**
+ * @brief Maps a new block for the slab.
+ *
+ * The block is at least a huge page long and as large as the blocks already
+ * mapped, so the slab doubles as it grows. The unused part of the previous
+ * block, if any, is abandoned until the slab is destroyed.
+ *
+ * @param s A pointer to the slab.
+ * @param items The number of items that must fit in the new block.
+ */
+static void slabGrow(Slab *s, long items) {
+  size_t size = items * s->itemSize;
+  if (size < s->mapped) {
+    size = s->mapped;
+  }
+  if (size < HUGE_PAGE_SIZE) {
+    size = HUGE_PAGE_SIZE;
+  }
+  if (s->blockCount == s->blockCapacity) {
+    s->blockCapacity = s->blockCapacity ? s->blockCapacity * 2 : 16;
+    s->blocks = realloc(s->blocks, sizeof(char *) * s->blockCapacity);
+    s->sizes = realloc(s->sizes, sizeof(size_t) * s->blockCapacity);
+  }
+  s->next = hugeAlloc(size);
+  s->end = s->next + size;
+  s->mapped += size;
+  s->sizes[s->blockCount] = size;
+  s->blocks[s->blockCount++] = s->next;
+}
+
+/**
+ * @brief Makes sure the slab can allocate a number of items without a new
+ * block.
+ *
+ * @param s A pointer to the slab.
+ * @param items The number of items about to be allocated.
+ */
+void slabReserve(Slab *s, long items) {
+  if ((s->end - s->next) / s->itemSize < items) {
+    slabGrow(s, items);
+  }
+}
+
+/**
+ * @brief Allocates an item from the slab.
+ *
+ * Freed items are reused first, then the item is taken from the current
+ * block.
+ *
+ * @param s A pointer to the slab.
+ * @return Returns a pointer to the item.
+ */
+void *slabAlloc(Slab *s) {
+  void *item;
+  slabLock(s);
+  if ((item = s->free) != NULL) {
+    s->free = *(void **)item;
+  } else {
+    slabReserve(s, 1);
+    item = s->next;
+    s->next += s->itemSize;
+  }
+  slabUnlock(s);
+  return item;
+}
+
+/**
+ * @brief Returns an item to the slab.
+ *
+ * @param s A pointer to the slab.
+ * @param item A pointer to the item, which must have come from the slab.
+ */
+void slabFree(Slab *s, void *item) {
+  slabLock(s);
+  *(void **)item = s->free;
+  s->free = item;
+  slabUnlock(s);
+}
+
+/**
+ * @brief Frees every block of the slab, and so every item allocated from it.
+ *
+ * @param s A pointer to the slab to be destroyed.
+ */
+void slabDestroy(Slab *s) {
+  for (int i = 0; i < s->blockCount; i++) {
+    hugeUnmap(s->blocks[i], s->sizes[i]);
+  }
+  free(s->blocks);
+  free(s->sizes);
+  slabInit(s, s->itemSize);
+}
@@ -0,0 +1,297 @@
+/**
+ * @file snapshot.c
+ * @brief Source file for the snapshots read by the reader threads of the
+ * server.
+ *
+ * This file contains the implementation of the reader threads of the server,
+ * which run the queries 'v', 'f' and 'p' with no arguments while the server
+ * keeps applying changes. The queries never read the Memory of the server.
+ * They read one of two replicas, copies of the system built by replaying the
+ * changes, 'p', 'r', 'e', 's' and 'i', that the server adds to a log after
+ * applying them. A change 'i' is logged with the rows it imported, not the
+ * path of its file, so the replicas never read the file again, which may
+ * have changed since. A replayer thread brings the replica that is not being read
+ * up to date and publishes it by incrementing the epoch. In epoch `e` the
+ * queries read `replicas[e % 2]`, so each query reads a consistent version,
+ * as the server was after some change, and the server never waits for them.
+ *
+ * The replicas are reclaimed by epochs: a reader announces the epoch in which
+ * it started a query, and the replayer only changes the replica of an older
+ * epoch once no reader announces one. A query waits until its replica has
+ * every change made by its client, so each client sees its own changes.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "project.h"
+
+/**
+ * @brief Waits until no reader thread reads a replica of an epoch before the
+ * current one.
+ *
+ * @param s A pointer to the snapshots.
+ * @param epoch The current epoch.
+ */
+static void waitReaders(Snapshots *s, long epoch) {
+  for (int i = 0; i < s->readerCount; i++) {
+    long announced;
+    while ((announced = atomic_load(&s->readers[i].epoch)) != NO_EPOCH &&
+           announced < epoch) {
+      sched_yield();
+    }
+  }
+}
+
+/**
+ * @brief Applies the log to the replica that is not being read, then
+ * publishes it, until the snapshots are stopped.
+ *
+ * @param arg A pointer to the snapshots.
+ * @return Always returns NULL.
+ */
+static void *replay(void *arg) {
+  Snapshots *s = arg;
+  char buffer[BUF_SIZE + 1];
+  Change change;
+  pthread_mutex_lock(&s->lock);
+  while (!s->stopping) {
+    long epoch = atomic_load(&s->epoch), last = s->first + s->count;
+    Replica *r = &s->replicas[(epoch + 1) % 2];
+    if (r->version == last) {
+      pthread_cond_wait(&s->logged, &s->lock);
+      continue;
+    }
+    pthread_mutex_unlock(&s->lock);
+    waitReaders(s, epoch);
+    for (long v = r->version; v < last; v++) {
+      pthread_mutex_lock(&s->lock);
+      change = s->log[v - s->first];
+      pthread_mutex_unlock(&s->lock);
+      if (change.line[0] != CM_IMPORT) {
+        strcpy(buffer, change.line);
+        execute(r->copy, buffer[0], buffer + 1);
+      } else if (change.size > 0) {
+        importRows(r->copy, change.rows, change.size);
+      }
+    }
+    pthread_mutex_lock(&s->lock);
+    r->version = last;
+    atomic_store(&s->epoch, epoch + 1);
+    last = s->replicas[epoch % 2].version - s->first;
+    for (long i = 0; i < last; i++) {
+      free(s->log[i].line);
+      free(s->log[i].rows);
+    }
+    s->count -= last;
+    s->first += last;
+    memmove(s->log, s->log + last, s->count * sizeof(Change));
+    pthread_cond_broadcast(&s->changed);
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+/**
+ * @brief Runs a query on the current replica.
+ *
+ * The query reads a copy of the Memory of the replica, with its own output
+ * and counters, so many readers can read the same replica.
+ *
+ * @param reader A pointer to the reader thread.
+ * @param q A pointer to the query.
+ */
+static void runQuery(Reader *reader, Query *q) {
+  Snapshots *s = reader->owner;
+  Memory m;
+  long epoch;
+  do {
+    epoch = atomic_load(&s->epoch);
+    atomic_store(&reader->epoch, epoch);
+  } while (atomic_load(&s->epoch) != epoch);
+  m = *s->replicas[epoch % 2].copy;
+  m.output = s->output;
+  m.out = open_memstream(&q->text, &q->length);
+  memset(&m.summary, 0, sizeof(Summary));
+  execute(&m, q->line[0], q->line + 1);
+  atomic_store(&reader->epoch, NO_EPOCH);
+  fclose(m.out);
+  q->summary = m.summary;
+}
+
+/**
+ * @brief Runs the queued queries until the snapshots are stopped.
+ *
+ * Each query waits for a replica with the changes of its client. The answered
+ * queries are handed back to the server, which is woken through `notify`.
+ *
+ * @param arg A pointer to the reader thread.
+ * @return Always returns NULL.
+ */
+static void *readQueries(void *arg) {
+  Reader *reader = arg;
+  Snapshots *s = reader->owner;
+  uint64_t one = 1;
+  Query *q;
+  pthread_mutex_lock(&s->lock);
+  while (!s->stopping) {
+    q = s->queries;
+    if (!q || s->replicas[atomic_load(&s->epoch) % 2].version < q->version) {
+      pthread_cond_wait(&s->changed, &s->lock);
+      continue;
+    }
+    s->queries = q->next;
+    pthread_mutex_unlock(&s->lock);
+    runQuery(reader, q);
+    pthread_mutex_lock(&s->lock);
+    q->next = s->answered;
+    s->answered = q;
+    write(s->notify, &one, sizeof(one));
+  }
+  pthread_mutex_unlock(&s->lock);
+  return NULL;
+}
+
+/**
+ * @brief Creates the replicas and starts the replayer and reader threads.
+ *
+ * The replicas keep the records the server keeps, see `retainRecords`.
+ *
+ * @param m A pointer to the Memory structure of the server, whose output the
+ * queries print as and whose retention policy the replicas follow.
+ * @param readers The number of reader threads.
+ * @return Returns a pointer to the snapshots.
+ */
+Snapshots *snapshotsStart(Memory *m, int readers) {
+  Snapshots *s = calloc(1, sizeof(Snapshots));
+  for (int i = 0; i < 2; i++) {
+    s->replicas[i].copy = malloc(sizeof(Memory));
+    initializeSystem(s->replicas[i].copy);
+    s->replicas[i].copy->output = OUTPUT_NONE;
+    s->replicas[i].copy->keepRecords = m->keepRecords;
+    s->replicas[i].copy->keepDays = m->keepDays;
+  }
+  atomic_init(&s->epoch, 0);
+  s->readerCount = readers;
+  s->output = m->output;
+  s->notify = eventfd(0, EFD_NONBLOCK);
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->logged, NULL);
+  pthread_cond_init(&s->changed, NULL);
+  pthread_create(&s->replayer, NULL, replay, s);
+  for (int i = 0; i < readers; i++) {
+    atomic_init(&s->readers[i].epoch, NO_EPOCH);
+    s->readers[i].owner = s;
+    pthread_create(&s->readers[i].thread, NULL, readQueries, &s->readers[i]);
+  }
+  return s;
+}
+
+/**
+ * @brief Adds a change, already applied by the server, to the log.
+ *
+ * @param s A pointer to the snapshots.
+ * @param line The command of the change.
+ * @param rows The rows imported by a command 'i', see `importRows`, which the
+ * log frees, or NULL for other commands.
+ * @param size The number of bytes of `rows`.
+ * @return Returns the version of the system with the change.
+ */
+long snapshotsLog(Snapshots *s, const char *line, char *rows, size_t size) {
+  long version;
+  pthread_mutex_lock(&s->lock);
+  if (s->count == s->capacity) {
+    s->capacity = s->capacity ? s->capacity * 2 : 1024;
+    s->log = realloc(s->log, s->capacity * sizeof(Change));
+  }
+  s->log[s->count++] = (Change){strdup(line), rows, size};
+  version = s->first + s->count;
+  pthread_cond_signal(&s->logged);
+  pthread_mutex_unlock(&s->lock);
+  return version;
+}
+
+/**
+ * @brief Queues a query for the reader threads.
+ *
+ * Queries are run in the order they are queued.
+ *
+ * @param s A pointer to the snapshots.
+ * @param q A pointer to the query.
+ */
+void snapshotsQuery(Snapshots *s, Query *q) {
+  q->next = NULL;
+  pthread_mutex_lock(&s->lock);
+  if (s->queries) {
+    s->last->next = q;
+  } else {
+    s->queries = q;
+  }
+  s->last = q;
+  pthread_cond_broadcast(&s->changed);
+  pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * @brief Takes the answered queries.
+ *
+ * @param s A pointer to the snapshots.
+ * @return Returns the list of answered queries, linked by `next`.
+ */
+Query *snapshotsAnswered(Snapshots *s) {
+  uint64_t count;
+  Query *answered;
+  read(s->notify, &count, sizeof(count));
+  pthread_mutex_lock(&s->lock);
+  answered = s->answered;
+  s->answered = NULL;
+  pthread_mutex_unlock(&s->lock);
+  return answered;
+}
+
+/**
+ * @brief Stops the threads and frees the snapshots.
+ *
+ * Queries still queued or answered are freed without being answered.
+ *
+ * @param s A pointer to the snapshots.
+ */
+void snapshotsStop(Snapshots *s) {
+  Query *lists[2];
+  pthread_mutex_lock(&s->lock);
+  s->stopping = 1;
+  pthread_cond_broadcast(&s->logged);
+  pthread_cond_broadcast(&s->changed);
+  pthread_mutex_unlock(&s->lock);
+  pthread_join(s->replayer, NULL);
+  for (int i = 0; i < s->readerCount; i++) {
+    pthread_join(s->readers[i].thread, NULL);
+  }
+  lists[0] = s->queries;
+  lists[1] = s->answered;
+  for (int i = 0; i < 2; i++) {
+    while (lists[i]) {
+      Query *next = lists[i]->next;
+      free(lists[i]->line);
+      free(lists[i]->text);
+      free(lists[i]);
+      lists[i] = next;
+    }
+  }
+  for (long i = 0; i < s->count; i++) {
+    free(s->log[i].line);
+    free(s->log[i].rows);
+  }
+  free(s->log);
+  cleanUp(s->replicas[0].copy);
+  cleanUp(s->replicas[1].copy);
+  close(s->notify);
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->logged);
+  pthread_cond_destroy(&s->changed);
+  free(s);
+}
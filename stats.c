@@ -0,0 +1,178 @@
+/**
+ * @file stats.c
+ * @brief Source file for the operational statistics of the parks.
+ *
+ * This file contains the implementation of the statistics kept by every park
+ * as its vehicles enter and leave: the number of entries and exits and the
+ * peak occupancy of each day with entries or exits, and the total, the count
+ * and a sketch of the lengths of the stays. Days are appended in order, since
+ * the entries and exits of a park are chronological. The sketch counts the
+ * stays in buckets: stays under 2^STAY_PRECISION minutes have a bucket each,
+ * and longer ones share a bucket with the stays that agree with them on the
+ * first STAY_PRECISION + 1 bits, so a quantile is read from a fixed number of
+ * buckets, within 2% of the exact value, however many stays there are.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "project.h"
+
+#define STATS_INITIAL_DAYS 64 /*Initial number of days in the statistics*/
+
+/**
+ * @brief Creates new, empty statistics.
+ *
+ * @return Returns a pointer to the newly created statistics.
+ */
+Stats *statsNew() {
+  Stats *s = calloc(1, sizeof(Stats));
+  return s;
+}
+
+/**
+ * @brief Finds the bucket of the sketch of a stay.
+ *
+ * @param minutes The length of the stay.
+ * @return Returns the bucket.
+ */
+static int stayBucket(Stamp minutes) {
+  int bits = 31 - __builtin_clz(minutes | 1), shift;
+  if (bits < STAY_PRECISION) {
+    return minutes;
+  }
+  shift = bits - STAY_PRECISION;
+  return (shift + 1) * (1 << STAY_PRECISION) +
+         ((minutes >> shift) & ((1 << STAY_PRECISION) - 1));
+}
+
+/**
+ * @brief Finds the stay that stands for a bucket of the sketch.
+ *
+ * @param bucket The bucket.
+ * @return Returns the middle of the stays of the bucket.
+ */
+static Stamp bucketStay(int bucket) {
+  int shift = bucket / (1 << STAY_PRECISION) - 1;
+  Stamp low;
+  if (shift < 0) {
+    return bucket;
+  }
+  low = (Stamp)((1 << STAY_PRECISION) + bucket % (1 << STAY_PRECISION))
+        << shift;
+  return low + ((1U << shift) >> 1);
+}
+
+/**
+ * @brief Finds the statistics of a day, appending the day if it is new.
+ *
+ * @param s A pointer to the statistics.
+ * @param day The day, never before the last one.
+ * @param occupancy The occupancy of the park at the start of the day.
+ * @return Returns a pointer to the statistics of the day.
+ */
+static DayStats *statsDay(Stats *s, int day, int occupancy) {
+  if (s->size == 0 || s->days[s->size - 1].day != day) {
+    if (s->size == s->capacity) {
+      s->capacity = s->capacity ? s->capacity * 2 : STATS_INITIAL_DAYS;
+      s->days = realloc(s->days, sizeof(DayStats) * s->capacity);
+    }
+    s->days[s->size].day = day;
+    s->days[s->size].entries = 0;
+    s->days[s->size].exits = 0;
+    s->days[s->size].peak = occupancy;
+    s->size++;
+  }
+  return &s->days[s->size - 1];
+}
+
+/**
+ * @brief Counts the entry of a vehicle in a park.
+ *
+ * @param s A pointer to the statistics of the park.
+ * @param now The date and time of the entry.
+ * @param occupancy The occupancy of the park after the entry.
+ */
+void statsEnter(Stats *s, Stamp now, int occupancy) {
+  DayStats *d = statsDay(s, STAMP_DAY(now), occupancy - 1);
+  d->entries++;
+  d->peak = occupancy > d->peak ? occupancy : d->peak;
+  s->entries++;
+}
+
+/**
+ * @brief Counts the exit of a vehicle from a park.
+ *
+ * @param s A pointer to the statistics of the park.
+ * @param r A pointer to the record of the stay, with its exit.
+ * @param occupancy The occupancy of the park after the exit.
+ */
+void statsExit(Stats *s, Record *r, int occupancy) {
+  Stamp stay = r->exit - r->entry;
+  statsDay(s, STAMP_DAY(r->exit), occupancy + 1)->exits++;
+  s->exits++;
+  s->stayed += stay;
+  s->stays[stayBucket(stay)]++;
+}
+
+/**
+ * @brief Estimates a quantile of the lengths of the stays.
+ *
+ * @param s A pointer to the statistics.
+ * @param percent The quantile, from 1 to 100.
+ * @return Returns the length of the stay of that rank, or 0 if there are no
+ * stays.
+ */
+Stamp statsQuantile(Stats *s, int percent) {
+  long rank = (s->exits * percent + 99) / 100, seen = 0;
+  for (int i = 0; rank > 0 && i < STAY_BUCKETS; i++) {
+    if ((seen += s->stays[i]) >= rank) {
+      return bucketStay(i);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Prints the statistics of a park on one line.
+ *
+ * The line has the name of the park, its entries and exits, the mean, median,
+ * 90th and 99th percentile of the stays, in minutes, and the exits per spot.
+ *
+ * @param p A pointer to the park.
+ * @param out The stream to print to.
+ */
+void statsPrint(Park *p, FILE *out) {
+  Stats *s = p->stats;
+  fprintf(out, "%s %ld %ld %ld %u %u %u %.2f\n", p->name, s->entries,
+          s->exits, s->exits ? s->stayed / s->exits : 0, statsQuantile(s, 50),
+          statsQuantile(s, 90), statsQuantile(s, 99),
+          (double)s->exits / p->capacity);
+}
+
+/**
+ * @brief Prints the entries, exits and peak occupancy of a park on each day
+ * with entries or exits.
+ *
+ * @param p A pointer to the park.
+ * @param out The stream to print to.
+ */
+void statsPrintDays(Park *p, FILE *out) {
+  char date[11];
+  for (int i = 0; i < p->stats->size; i++) {
+    DayStats *d = &p->stats->days[i];
+    intToDate(d->day, date);
+    fprintf(out, "%s %d %d %d\n", date, d->entries, d->exits, d->peak);
+  }
+}
+
+/**
+ * @brief Frees the statistics of a park.
+ *
+ * @param s A pointer to the statistics.
+ */
+void freeStats(Stats *s) {
+  free(s->days);
+  free(s);
+}
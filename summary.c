@@ -0,0 +1,142 @@
+/**
+ * @file summary.c
+ * @brief Source file for the error reporting and the summary of a run.
+ *
+ * This file contains the implementation of `reject`, through which every
+ * error message is printed, and of the summary printed at the end of a run in
+ * the quiet modes. Errors are counted by message, so the reasons in the
+ * summary are the error messages themselves, without their arguments.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "project.h"
+
+/**
+ * @brief Adds to the count of an error message.
+ *
+ * @param s A pointer to the counters.
+ * @param format The format of the error message.
+ * @param n The number of times the error was printed.
+ */
+static void countReason(Summary *s, const char *format, long n) {
+  int i = 0;
+  while (i < s->reasonCount && strcmp(s->reasons[i], format) != 0) {
+    i++;
+  }
+  if (i == s->reasonCount && i < MAX_REASONS) {
+    s->reasons[s->reasonCount++] = format;
+    s->rejections[i] = 0;
+  }
+  if (i < s->reasonCount) {
+    s->rejections[i] += n;
+  }
+}
+
+/**
+ * @brief Prints an error message, unless errors are only counted, and counts
+ * it.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param format The format of the error message, one of the ERR_ macros.
+ * @param ... The arguments of the error message.
+ */
+void reject(Memory *m, const char *format, ...) {
+  va_list args;
+  if (m->output != OUTPUT_NONE) {
+    va_start(args, format);
+    vfprintf(m->out, format, args);
+    va_end(args);
+  }
+  countReason(&m->summary, format, 1);
+}
+
+/**
+ * @brief Counts a command read from the input.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param command The first character of the command.
+ */
+void countCommand(Memory *m, char command) {
+  if (command > ' ' && command < 127) {
+    m->summary.commands[(int)command]++;
+  }
+}
+
+/**
+ * @brief Adds the errors counted elsewhere, such as by a reader thread of the
+ * server, to the counters of a run.
+ *
+ * @param m A pointer to the Memory structure.
+ * @param s A pointer to the counters to be added.
+ */
+void mergeSummary(Memory *m, Summary *s) {
+  for (int i = 0; i < s->reasonCount; i++) {
+    countReason(&m->summary, s->reasons[i], s->rejections[i]);
+  }
+}
+
+/**
+ * @brief Prints an error message format without its arguments.
+ *
+ * The argument before the colon, if any, and the final period are left out,
+ * so "%s: parking is full.\n" is printed as "parking is full".
+ *
+ * @param format The format of the error message.
+ * @param out The stream to print to.
+ */
+static void printReason(const char *format, FILE *out) {
+  const char *start = strstr(format, ": ");
+  int length;
+  start = start ? start + 2 : format;
+  length = strlen(start);
+  while (length > 0 && (start[length - 1] == '\n' || start[length - 1] == '.')) {
+    length--;
+  }
+  fprintf(out, "%.*s", length, start);
+}
+
+/**
+ * @brief Prints the summary of a run.
+ *
+ * The summary has three sections, each starting with its total: the commands
+ * read, by type, the errors, by reason, and the revenue of each park.
+ *
+ * @param m A pointer to the Memory structure.
+ */
+void printSummary(Memory *m) {
+  Summary *s = &m->summary;
+  long total = 0;
+  Cents revenue = 0;
+  for (int c = 0; c < 128; c++) {
+    total += s->commands[c];
+  }
+  fprintf(m->out, "commands %ld\n", total);
+  for (int c = 0; c < 128; c++) {
+    if (s->commands[c]) {
+      fprintf(m->out, "%c %ld\n", c, s->commands[c]);
+    }
+  }
+  total = 0;
+  for (int i = 0; i < s->reasonCount; i++) {
+    total += s->rejections[i];
+  }
+  fprintf(m->out, "rejections %ld\n", total);
+  for (int i = 0; i < s->reasonCount; i++) {
+    printReason(s->reasons[i], m->out);
+    fprintf(m->out, " %ld\n", s->rejections[i]);
+  }
+  for (Node *n = m->parks->head; n; n = n->next) {
+    Revenue *r = n->item.park->revenue;
+    revenue += r->size > 0 ? r->prefix[r->size - 1] : 0;
+  }
+  fprintf(m->out, "revenue " CENTS_FMT "\n", CENTS_ARG(revenue));
+  for (Node *n = m->parks->head; n; n = n->next) {
+    Revenue *r = n->item.park->revenue;
+    fprintf(m->out, "%s " CENTS_FMT "\n", n->item.park->name,
+           CENTS_ARG(r->size > 0 ? r->prefix[r->size - 1] : 0));
+  }
+}
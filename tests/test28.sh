@@ -0,0 +1,14 @@
+#!/bin/bash
+# Runs the commands on stdin with fewer records reserved than they add and
+# with more, which must not change their output, then with sizes out of
+# range, which are refused before any command is read, and with a size that
+# cannot be mapped under a limit of memory, which ends with an error.
+INPUT=$(cat)
+for n in 1 100000 0 268435457 x; do
+  echo "-n $n"
+  ../proj1 -n $n <<< "$INPUT" 2>&1
+  echo "exit $?"
+done
+echo "-n 200000000, ulimit -v 2000000"
+(ulimit -v 2000000; ../proj1 -n 200000000 <<< "$INPUT" 2>&1)
+echo "exit $?"
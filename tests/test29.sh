@@ -0,0 +1,20 @@
+#!/bin/bash
+# Runs the commands on stdin with an event ring, then drains the ring with
+# the reader in tools from its oldest event, while the program still holds
+# it, and writes the output of the program followed by the events.
+RING=/proj1-test29
+make -s -C ../tools events > /dev/null
+INPUT=$(cat)
+OUTPUT=$(mktemp)
+{
+  echo "$INPUT" | sed '/^q$/d'
+  while [ ! -e /dev/shm$RING ]; do sleep 0.01; done
+  ../tools/events -o $RING > $OUTPUT.events &
+  while ! grep -qs "$RING" /proc/$!/maps; do sleep 0.01; done
+  echo q
+  wait
+} | ../proj1 -e $RING > $OUTPUT
+cat $OUTPUT
+echo "events:"
+cat $OUTPUT.events
+rm -f $OUTPUT $OUTPUT.events
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Runs the commands on stdin with a trace, then checks that the trace is
+# Chrome trace-event JSON of complete spans, each one inside a span of
+# `execute` of its thread, and writes how many spans each name has.
+TRACE=$(mktemp)
+../proj1 -t $TRACE
+python3 - $TRACE <<'PYTHON'
+import collections, json, sys
+trace = json.load(open(sys.argv[1]))
+spans = trace["traceEvents"]
+assert trace["displayTimeUnit"] == "ns"
+for s in spans:
+    assert set(s) == {"name", "cat", "ph", "pid", "tid", "ts", "dur"}, s
+    assert s["ph"] == "X" and s["cat"] == "proj1" and s["dur"] >= 0, s
+outer = [s for s in spans if s["name"] == "execute"]
+for s in spans:
+    assert any(o["tid"] == s["tid"] and o["ts"] <= s["ts"] and
+               s["ts"] + s["dur"] <= o["ts"] + o["dur"] for o in outer), s
+print("trace: %d spans" % len(spans))
+for name, count in sorted(collections.Counter(s["name"] for s in spans).items()):
+    print(name, count)
+PYTHON
+rm -f $TRACE
@@ -0,0 +1,19 @@
+#!/bin/bash
+# Runs the commands on stdin through the server with two reader threads: up
+# to the first q by a client, which imports test38.csv, and the rest by
+# another client once the import file is gone, so the replicas read by the
+# queries must have the rows they were sent, not read the file again.
+SOCKET=/tmp/proj1-test38.sock
+make -s -C ../tools client > /dev/null
+cp test38.csv test38.tmp.csv
+rm -f $SOCKET
+../proj1 -s $SOCKET -r 2 &
+SERVER=$!
+while [ ! -S $SOCKET ]; do sleep 0.01; done
+INPUT=$(cat)
+sed '/^q$/q' <<< "$INPUT" | ../tools/client $SOCKET
+rm test38.tmp.csv
+sed '1,/^q$/d' <<< "$INPUT" | ../tools/client $SOCKET
+kill -TERM $SERVER
+wait $SERVER
+rm -f $SOCKET
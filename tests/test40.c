@@ -0,0 +1,128 @@
+/**
+ * @file test40.c
+ * @brief Test of the library, linked against libpark.a.
+ *
+ * Calls the library on the success path and on each error it reports,
+ * through park.h alone, writing one line per call with the status expected
+ * and, if it differs, the status returned. The errors of the binary frames
+ * are tested by test45.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "park.h"
+
+static int failed; /*Number of calls that returned another status*/
+
+/**
+ * @brief Checks the status returned by a call.
+ *
+ * @param call The call, as text.
+ * @param status The status returned.
+ * @param expected The status expected.
+ */
+static void check(const char *call, int status, int expected) {
+  if (status == expected) {
+    printf("%s: %d\n", call, status);
+  } else {
+    printf("%s: %d, expected %d\n", call, status, expected);
+    failed++;
+  }
+}
+
+/**
+ * @brief Main function of the test.
+ *
+ * @return Returns 0, or 1 if a call returned another status.
+ */
+int main() {
+  ParkSystem *s = parkOpen();
+  Plate first = parkPlate("AA-00-AA"), second = parkPlate("BB-11-BB");
+  int day = parkDay(1, 1, 2024), id, full, big, spots, count, status = ST_OK;
+  ParkPayment payment, *payments;
+  ParkVisit *visits;
+  ParkDay *days;
+  Cents total;
+  char name[16];
+  check("parkAdd", parkAdd(s, "A", 10, 25, 30, 1000, &id), ST_OK);
+  check("parkAdd existing", parkAdd(s, "A", 10, 25, 30, 1000, &id),
+        ST_PARK_EXISTS);
+  check("parkAdd no capacity", parkAdd(s, "B", 0, 25, 30, 1000, &id),
+        ST_INVALID_CAPACITY);
+  check("parkAdd decreasing cost", parkAdd(s, "B", 10, 30, 25, 1000, &id),
+        ST_INVALID_COST);
+  check("parkAdd full", parkAdd(s, "full", 1, 25, 30, 1000, &full), ST_OK);
+  check("parkAdd big", parkAdd(s, "big", 10, 100, 200, 2000000000, &big),
+        ST_OK);
+  for (int i = 3; status == ST_OK; i++) {
+    sprintf(name, "P%d", i);
+    status = parkAdd(s, name, 1, 25, 30, 1000, &count);
+  }
+  check("parkAdd too many", status, ST_TOO_MANY_PARKS);
+  check("parkRemove", parkRemove(s, count), ST_OK);
+  check("parkRemove missing", parkRemove(s, count), ST_PARK_NOT_FOUND);
+  check("parkEnter", parkEnter(s, id, first, parkStamp(day, 8, 0), &spots),
+        ST_OK);
+  check("parkEnter missing park",
+        parkEnter(s, count, second, parkStamp(day, 8, 0), &spots),
+        ST_PARK_NOT_FOUND);
+  check("parkEnter invalid plate",
+        parkEnter(s, id, parkPlate("AA-BB-CC"), parkStamp(day, 8, 0), &spots),
+        ST_INVALID_LICENSE);
+  check("parkEnter inside",
+        parkEnter(s, id, first, parkStamp(day, 8, 10), &spots),
+        ST_INVALID_ENTRY);
+  check("parkEnter past", parkEnter(s, id, second, parkStamp(day, 7, 0), &spots),
+        ST_INVALID_DATE);
+  check("parkEnter", parkEnter(s, full, second, parkStamp(day, 9, 0), &spots),
+        ST_OK);
+  check("parkEnter full park",
+        parkEnter(s, full, parkPlate("CC-22-CC"), parkStamp(day, 9, 0), &spots),
+        ST_FULL_PARK);
+  check("parkExit", parkExit(s, id, first, parkStamp(day, 10, 0), &payment),
+        ST_OK);
+  check("parkExit outside",
+        parkExit(s, id, first, parkStamp(day, 10, 0), &payment),
+        ST_INVALID_EXIT);
+  check("parkExit past", parkExit(s, full, second, parkStamp(day, 9, 59),
+                                  &payment),
+        ST_INVALID_DATE);
+  check("parkVehicle", parkVehicle(s, first, &visits, &count), ST_OK);
+  free(visits);
+  check("parkVehicle no entries",
+        parkVehicle(s, parkPlate("DD-33-DD"), &visits, &count), ST_NO_ENTRIES);
+  check("parkVehicle invalid plate",
+        parkVehicle(s, parkPlate("00-00-00"), &visits, &count),
+        ST_INVALID_LICENSE);
+  check("parkBills", parkBills(s, id, &days, &count), ST_OK);
+  free(days);
+  check("parkBillsDate", parkBillsDate(s, id, day, &payments, &count), ST_OK);
+  free(payments);
+  check("parkBillsDate future",
+        parkBillsDate(s, id, day + 1, &payments, &count), ST_INVALID_DATE);
+  check("parkBillsRange", parkBillsRange(s, id, day, day, &total), ST_OK);
+  check("parkBillsRange reversed",
+        parkBillsRange(s, id, day, day - 1, &total), ST_INVALID_DATE);
+  check("parkBills missing park", parkBills(s, -1, &days, &count),
+        ST_PARK_NOT_FOUND);
+  Plate plates[] = {parkPlate("EE-44-EE"), parkPlate("FF-55-FF"),
+                    parkPlate("GG-66-GG")};
+  for (int i = 0; i < 3; i++) {
+    parkEnter(s, big, plates[i], parkStamp(day + 1, 0, 0), &spots);
+  }
+  for (int i = 0; i < 3; i++) {
+    check("parkExit big",
+          parkExit(s, big, plates[i], parkStamp(day + 2, 0, 0), &payment),
+          ST_OK);
+  }
+  check("parkPlate short", parkPlate("AA") == NO_PLATE, 1);
+  check("parkPlate no dashes", parkPlate("AAx00yAA") == NO_PLATE, 1);
+  check("parkPlate long", parkPlate("AA-00-AA-") == NO_PLATE, 1);
+  check("parkCommand", parkCommand(s, "p C 1 1 1 1"), ST_OK);
+  check("parkCommand rejected", parkCommand(s, "p A 1 1 1 1"), ST_REJECTED);
+  check("parkCommand empty", parkCommand(s, ""), ST_REJECTED);
+  parkClose(s);
+  return failed > 0;
+}
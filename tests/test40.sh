@@ -0,0 +1,8 @@
+#!/bin/bash
+# Builds the test of the library in test40.c against libpark.a and runs it.
+PROGRAM=$(mktemp)
+make -s -C .. libpark.a > /dev/null
+gcc -O2 -Wall -Wextra -Werror -pthread -I.. -o $PROGRAM test40.c ../libpark.a
+$PROGRAM
+echo "exit $?"
+rm -f $PROGRAM
@@ -0,0 +1,34 @@
+#!/bin/bash
+# Runs several clients at once on the server with a reader thread: each adds
+# a park and parks a vehicle in it, while others send queries and hang up
+# without reading the answers. Then the commands on stdin are run by another
+# client, followed by the parks, sorted, and then the line of its own park
+# in the output of each of the first clients, since the other parks it lists
+# depend on the order the clients ran in.
+SOCKET=/tmp/proj1-test41.sock
+OUTPUT=$(mktemp -d)
+make -s -C ../tools client > /dev/null
+rm -f $SOCKET
+../proj1 -s $SOCKET -r 1 &
+SERVER=$!
+while [ ! -S $SOCKET ]; do sleep 0.01; done
+for i in 1 2 3 4; do
+  printf 'p P%d %d 0.25 0.30 10.00\ne P%d AA-0%d-AA 01-01-2024 08:00\np\nq\n' \
+    $i $i $i $i | ../tools/client $SOCKET > $OUTPUT/$i &
+  python3 -c '
+import socket, sys
+s = socket.socket(socket.AF_UNIX)
+s.connect(sys.argv[1])
+s.sendall(b"p\nv AA-01-AA\np P1\n")
+s.close()' $SOCKET &
+done
+wait $(jobs -p | grep -v "^$SERVER$")
+../tools/client $SOCKET
+echo p | ../tools/client $SOCKET | sort
+for i in 1 2 3 4; do
+  grep -x "P$i $i $((i - 1))" $OUTPUT/$i
+done
+kill -TERM $SERVER
+wait $SERVER
+echo "exit $?"
+rm -rf $SOCKET $OUTPUT
@@ -0,0 +1,39 @@
+/**
+ * @file test43.c
+ * @brief Test of the quoting of park names in CSV export files, linked
+ * against libpark.a.
+ *
+ * Adds parks whose names have quotes and commas, which text commands cannot
+ * give, and exports their records as CSV with the text command 'x', run by
+ * `parkCommand`, to CSV_PATH.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include "park.h"
+
+#define CSV_PATH "test43.tmp.csv" /*The CSV file exported*/
+
+/*Names of the parks, with the quotes and commas CSV must escape*/
+static const char *names[] = {"say \"hi\", park", "\"quoted\"", "plain"};
+
+/**
+ * @brief Main function of the test.
+ *
+ * @return Returns 0.
+ */
+int main() {
+  ParkSystem *s = parkOpen();
+  Plate plate = parkPlate("AA-00-AA");
+  int day = parkDay(1, 1, 2024), id, spots;
+  ParkPayment payment;
+  for (int i = 0; i < 3; i++) {
+    parkAdd(s, names[i], 10, 25, 30, 1000, &id);
+    parkEnter(s, id, plate, parkStamp(day, 8 + 2 * i, 0), &spots);
+    if (i < 2) {
+      parkExit(s, id, plate, parkStamp(day, 9 + 2 * i, 0), &payment);
+    }
+  }
+  parkCommand(s, "x " CSV_PATH " csv");
+  parkClose(s);
+  return 0;
+}
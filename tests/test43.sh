@@ -0,0 +1,14 @@
+#!/bin/bash
+# Builds the test in test43.c against libpark.a and runs it, then prints the
+# CSV file it exported and the park names a CSV reader finds in it.
+PROGRAM=$(mktemp)
+make -s -C .. libpark.a > /dev/null
+gcc -O2 -Wall -Wextra -Werror -pthread -I.. -o $PROGRAM test43.c ../libpark.a
+$PROGRAM
+echo "exit $?"
+cat test43.tmp.csv
+python3 -c '
+import csv, sys
+for row in csv.reader(open(sys.argv[1], newline="")):
+    print(len(row), row[0])' test43.tmp.csv
+rm -f $PROGRAM test43.tmp.csv
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Converts the commands on stdin to frames, with the text '#' replaced by a
+# 'T' frame whose text is longer than BUF_SIZE and made of 'Z' frames and
+# the text '?' by a frame of the unknown operation 'Z', and runs them with
+# -b, printing the responses as text. The long text must be
+# skipped whole, and the exit whose amount does not fit in a frame must be
+# recorded and answered with status overflow.
+make -s -C ../tools convert > /dev/null
+../tools/convert -b | python3 -c '
+import struct, sys
+data, out, i = sys.stdin.buffer.read(), sys.stdout.buffer, 0
+while i < len(data):
+    frame = data[i:i + 16]
+    op, status, park, plate, a, b = struct.unpack("<BBHIII", frame)
+    text = data[i + 16:i + 16 + a] if op == ord("T") else b""
+    i += 16 + len(text)
+    if text == b"#":
+        skipped = struct.pack("<BBHIII", ord("Z"), 0, 0, 0, 0, 0) * 563
+        frame = struct.pack("<BBHIII", op, 0, 0, 0, len(skipped), 0)
+        text = skipped
+    elif text == b"?":
+        frame, text = struct.pack("<BBHIII", ord("Z"), 0, 0, 0, 0, 0), b""
+    out.write(frame + text)' | ../proj1 -b | ../tools/convert -t
@@ -0,0 +1,229 @@
+/**
+ * @file test46.c
+ * @brief Test of entries and exits from many threads, linked against
+ * libpark.a.
+ *
+ * The same entries and exits are run on two systems: on one by THREADS
+ * threads at once, one per gate, each with its own vehicles, and on the
+ * other by a single thread. Each step is a minute at which every gate enters
+ * or exits some of its vehicles, and the threads wait for each other between
+ * steps, so no gate is rejected for a minute another has passed. The bills
+ * of each park, its free spots and the records of each vehicle must be the
+ * same in both systems.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "park.h"
+
+#define THREADS 4  /*Gates entering and exiting vehicles at once*/
+#define VEHICLES 300 /*Vehicles of each gate*/
+#define PARKS 4    /*Parks the vehicles are spread over*/
+#define ROUNDS 3   /*Days on which the vehicles enter and exit*/
+#define GROUPS 3   /*Minutes of the entries, and of the exits, of a day*/
+#define STEPS (ROUNDS * GROUPS * 2) /*Steps of each gate*/
+
+/**
+ * @brief Structure to hold a gate run by a thread.
+ *
+ * @param s A pointer to the system.
+ * @param parks The ids of the parks.
+ * @param gate The number of the gate.
+ * @param barrier The barrier the gates wait at between steps.
+ * @param failed The number of calls that did not return ST_OK.
+ */
+typedef struct {
+  ParkSystem *s;
+  int *parks;
+  int gate;
+  pthread_barrier_t *barrier;
+  int failed;
+} Gate;
+
+/**
+ * @brief Gives the license plate of a vehicle of a gate.
+ *
+ * @param gate The number of the gate.
+ * @param vehicle The number of the vehicle in the gate.
+ * @return Returns the encoded license plate.
+ */
+static Plate plateOf(int gate, int vehicle) {
+  char text[9];
+  sprintf(text, "%c%c-%02d-00", 'A' + gate, 'A' + vehicle / 100,
+          vehicle % 100);
+  return parkPlate(text);
+}
+
+/**
+ * @brief Enters or exits the vehicles of a gate for a step.
+ *
+ * On each day, the vehicles enter in GROUPS groups, at 08:00, 09:10 and
+ * so on, and exit in the same groups at 18:00, 19:07 and so on, each one in
+ * a park that changes every day. On the last day, half of them stay
+ * inside.
+ *
+ * @param s A pointer to the system.
+ * @param parks The ids of the parks.
+ * @param gate The number of the gate.
+ * @param step The step.
+ * @return Returns the number of calls that did not return ST_OK.
+ */
+static int runStep(ParkSystem *s, int *parks, int gate, int step) {
+  int round = step / (GROUPS * 2), group = step % GROUPS;
+  int exit = step % (GROUPS * 2) >= GROUPS, day = parkDay(1, 1, 2024) + round;
+  int failed = 0, spots;
+  ParkPayment payment;
+  for (int i = group; i < VEHICLES; i += GROUPS) {
+    int park = parks[(gate + i + round) % PARKS];
+    if (!exit) {
+      failed += parkEnter(s, park, plateOf(gate, i),
+                          parkStamp(day, 8 + group, 10 * group), &spots) != ST_OK;
+    } else if (round < ROUNDS - 1 || i % 2 == 0) {
+      failed += parkExit(s, park, plateOf(gate, i),
+                         parkStamp(day, 18 + group, 7 * group), &payment) != ST_OK;
+    }
+  }
+  return failed;
+}
+
+/**
+ * @brief Runs every step of a gate, waiting for the other gates after each.
+ *
+ * @param arg A pointer to the Gate.
+ * @return Returns NULL.
+ */
+static void *runGate(void *arg) {
+  Gate *g = arg;
+  for (int step = 0; step < STEPS; step++) {
+    g->failed += runStep(g->s, g->parks, g->gate, step);
+    pthread_barrier_wait(g->barrier);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Opens a system with PARKS parks.
+ *
+ * @param parks Where the ids of the parks are stored.
+ * @return Returns a pointer to the system.
+ */
+static ParkSystem *openParks(int *parks) {
+  ParkSystem *s = parkOpen();
+  char name[16];
+  for (int i = 0; i < PARKS; i++) {
+    sprintf(name, "P%d", i);
+    parkAdd(s, name, VEHICLES * THREADS, 25 + i, 30 + i, 5000 + i,
+            &parks[i]);
+  }
+  return s;
+}
+
+/**
+ * @brief Compares the bills and the free spots of a park in both systems,
+ * and prints them.
+ *
+ * @param threaded A pointer to the system run by the threads.
+ * @param serial A pointer to the system run by a single thread.
+ * @param park The number of the park.
+ * @param ids The id of the park in each system.
+ * @return Returns 1 if they differ, or 0.
+ */
+static int compareParks(ParkSystem *threaded, ParkSystem *serial, int park,
+                        int ids[2]) {
+  ParkDay *days[2];
+  int counts[2], spots[2], differ = 0;
+  Stamp now = parkStamp(parkDay(1, 1, 2024) + ROUNDS, 0, 0);
+  Cents total = 0;
+  parkBills(threaded, ids[0], &days[0], &counts[0]);
+  parkBills(serial, ids[1], &days[1], &counts[1]);
+  differ = counts[0] != counts[1];
+  for (int i = 0; i < counts[0] && !differ; i++) {
+    differ = days[0][i].day != days[1][i].day ||
+             days[0][i].total != days[1][i].total;
+    total += days[0][i].total;
+  }
+  parkEnter(threaded, ids[0], parkPlate("ZZ-00-00"), now, &spots[0]);
+  parkEnter(serial, ids[1], parkPlate("ZZ-00-00"), now, &spots[1]);
+  differ = differ || spots[0] != spots[1];
+  printf("park %d: %d days, %ld cents, %d spots%s\n", park, counts[0], total,
+         spots[0], differ ? ", differs" : "");
+  free(days[0]);
+  free(days[1]);
+  return differ;
+}
+
+/**
+ * @brief Compares the records of every vehicle in both systems.
+ *
+ * @param threaded A pointer to the system run by the threads.
+ * @param serial A pointer to the system run by a single thread.
+ * @return Returns the number of vehicles whose records differ.
+ */
+static int compareVehicles(ParkSystem *threaded, ParkSystem *serial) {
+  ParkVisit *visits[2];
+  int counts[2], differ = 0;
+  for (int gate = 0; gate < THREADS; gate++) {
+    for (int i = 0; i < VEHICLES; i++) {
+      int status[2], same;
+      status[0] = parkVehicle(threaded, plateOf(gate, i), &visits[0],
+                              &counts[0]);
+      status[1] = parkVehicle(serial, plateOf(gate, i), &visits[1],
+                              &counts[1]);
+      same = status[0] == ST_OK && status[1] == ST_OK &&
+             counts[0] == counts[1];
+      for (int j = 0; j < counts[0] && same; j++) {
+        same = visits[0][j].park == visits[1][j].park &&
+               visits[0][j].entry == visits[1][j].entry &&
+               visits[0][j].exit == visits[1][j].exit;
+      }
+      differ += !same;
+      for (int k = 0; k < 2; k++) {
+        if (status[k] == ST_OK) {
+          free(visits[k]);
+        }
+      }
+    }
+  }
+  return differ;
+}
+
+/**
+ * @brief Main function of the test.
+ *
+ * @return Returns 0, or 1 if a call failed or the systems differ.
+ */
+int main() {
+  int parks[2][PARKS], failed = 0, differ = 0, vehicles;
+  ParkSystem *threaded = openParks(parks[0]), *serial = openParks(parks[1]);
+  pthread_t threads[THREADS];
+  pthread_barrier_t barrier;
+  Gate gates[THREADS];
+  pthread_barrier_init(&barrier, NULL, THREADS);
+  for (int i = 0; i < THREADS; i++) {
+    gates[i] = (Gate){threaded, parks[0], i, &barrier, 0};
+    pthread_create(&threads[i], NULL, runGate, &gates[i]);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    failed += gates[i].failed;
+  }
+  pthread_barrier_destroy(&barrier);
+  for (int step = 0; step < STEPS; step++) {
+    for (int gate = 0; gate < THREADS; gate++) {
+      failed += runStep(serial, parks[1], gate, step);
+    }
+  }
+  printf("failed calls: %d\n", failed);
+  for (int i = 0; i < PARKS; i++) {
+    int ids[2] = {parks[0][i], parks[1][i]};
+    differ += compareParks(threaded, serial, i, ids);
+  }
+  vehicles = compareVehicles(threaded, serial);
+  printf("vehicles that differ: %d\n", vehicles);
+  parkClose(threaded);
+  parkClose(serial);
+  return failed > 0 || differ > 0 || vehicles > 0;
+}
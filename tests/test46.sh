@@ -0,0 +1,9 @@
+#!/bin/bash
+# Builds the test of entries and exits from many threads in test46.c against
+# libpark.a and runs it.
+PROGRAM=$(mktemp)
+make -s -C .. libpark.a > /dev/null
+gcc -O2 -Wall -Wextra -Werror -pthread -I.. -o $PROGRAM test46.c ../libpark.a
+$PROGRAM
+echo "exit $?"
+rm -f $PROGRAM
@@ -0,0 +1,106 @@
+/**
+ * @file client.c
+ * @brief Client of the server mode of the program.
+ *
+ * Sends the text commands read from stdin to the server listening on the
+ * given Unix domain socket, and writes its responses to stdout, until the
+ * server closes the connection. Sending and receiving overlap, so long
+ * inputs do not wait for the server to take them all before their output is
+ * read. Many clients can be run at once to load the server.
+ *
+ * Usage:
+ *   ../proj1 -s /tmp/park.sock &
+ *   client /tmp/park.sock < commands.txt
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "project.h"
+
+/**
+ * @brief Connects to the server.
+ *
+ * @param path The path of the socket of the server.
+ * @return Returns the connected socket, or -1 if it cannot connect.
+ */
+static int connectServer(const char *path) {
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || strlen(path) >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+  if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Sends stdin to the server and writes its responses to stdout.
+ *
+ * Input is only read once the previous input was all sent, and the socket is
+ * written only when it takes more, so that a server that stops reading until
+ * its responses are read is never waited on.
+ *
+ * @param fd The socket connected to the server.
+ */
+static void talk(int fd) {
+  struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {fd, POLLIN, 0}};
+  char input[BUF_SIZE], output[BUF_SIZE];
+  ssize_t length = 0, sent = 0, n;
+  while (poll(fds, 2, -1) > 0) {
+    if (fds[0].revents && sent == length) {
+      if ((length = read(STDIN_FILENO, input, BUF_SIZE)) > 0) {
+        sent = 0;
+        fds[0].events = 0;
+        fds[1].events = POLLIN | POLLOUT;
+      } else {
+        shutdown(fd, SHUT_WR);
+        fds[0].fd = -1;
+      }
+    }
+    if ((fds[1].revents & POLLOUT) &&
+        (n = send(fd, input + sent, length - sent, MSG_DONTWAIT)) > 0 &&
+        (sent += n) == length) {
+      fds[0].events = POLLIN;
+      fds[1].events = POLLIN;
+    }
+    if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+      if ((n = read(fd, output, BUF_SIZE)) <= 0) {
+        return;
+      }
+      write(STDOUT_FILENO, output, n);
+    }
+  }
+}
+
+/**
+ * @brief Main function of the client.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return Returns 0, or 1 if the arguments are not valid or the server cannot
+ * be reached.
+ */
+int main(int argc, char *argv[]) {
+  int fd;
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <socket>\n", argv[0]);
+    return 1;
+  }
+  if ((fd = connectServer(argv[1])) < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  talk(fd);
+  close(fd);
+  return 0;
+}
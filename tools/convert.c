@@ -0,0 +1,214 @@
+/**
+ * @file convert.c
+ * @brief Converter between the text and binary formats of the commands.
+ *
+ * With -b, text commands read from stdin are written to stdout as request
+ * frames for `proj1 -b`. Commands 'e', 's', 'v' and 'f' on known parks become
+ * binary requests, and every other command is carried as text in a 'T' frame.
+ * Commands 'p' and 'r' are also run on a copy of the system with no output,
+ * so the parks get the same ids they get in the program. With -t, response
+ * frames read from stdin are written to stdout as text, with parks by id.
+ *
+ * Usage:
+ *   convert -b < commands.txt > requests.bin
+ *   convert -t < responses.bin > responses.txt
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "project.h"
+
+/*Text of each status code of the responses*/
+static const char *statusNames[] = {
+    "ok",           "no such parking", "parking is full",
+    "invalid licence plate", "invalid vehicle entry", "invalid vehicle exit",
+    "invalid date", "no entries found", "rejected",
+    "invalid frame", "parking already exists", "invalid capacity",
+    "invalid cost", "too many parks", "overflow"};
+
+/**
+ * @brief Reads the park name at the start of the arguments of a command.
+ *
+ * @param m A pointer to the copy of the system.
+ * @param buffer The arguments of the command.
+ * @param rest A pointer to where the arguments after the name are stored.
+ * @return Returns a pointer to the park, or NULL if there is no such park.
+ */
+static Park *readPark(Memory *m, char *buffer, char **rest) {
+  char name[BUF_SIZE] = "";
+  int offset = 0;
+  if (strchr(buffer, '\"')) {
+    sscanf(buffer, " \"%[^\"]\"%n", name, &offset);
+  } else {
+    sscanf(buffer, "%s%n", name, &offset);
+  }
+  *rest = buffer + offset;
+  return getPark(m, name);
+}
+
+/**
+ * @brief Writes a text command as a 'T' frame.
+ *
+ * @param command The first character of the command.
+ * @param buffer The arguments of the command.
+ */
+static void writeText(char command, char *buffer) {
+  Frame f = {CM_TEXT, ST_OK, 0, 0, strlen(buffer) + 1, 0};
+  writeFrame(&f, stdout);
+  fputc(command, stdout);
+  fputs(buffer, stdout);
+}
+
+/**
+ * @brief Converts a text command to a request frame.
+ *
+ * @param m A pointer to the copy of the system.
+ * @param command The first character of the command.
+ * @param buffer The arguments of the command.
+ */
+static void convertCommand(Memory *m, char command, char *buffer) {
+  char plates[BUF_SIZE] = "", date[BUF_SIZE] = "", date2[BUF_SIZE] = "",
+       time[BUF_SIZE] = "";
+  Frame f = {command, ST_OK, 0, 0, 0, 0};
+  char *rest;
+  Park *p = NULL;
+  if (command == CM_ADD_VEHICLE || command == CM_EXIT_VEHICLE ||
+      command == CM_GET_BILLS) {
+    p = readPark(m, buffer, &rest);
+  }
+  if ((command == CM_ADD_VEHICLE || command == CM_EXIT_VEHICLE) && p) {
+    sscanf(rest, "%s %s %s", plates, date, time);
+    f.park = p->id;
+    f.plate = encodePlate(plates);
+    f.a = parseStamp(date, time);
+    writeFrame(&f, stdout);
+  } else if (command == CM_GET_BILLS && p) {
+    int count = sscanf(rest, "%10s %10s", date, date2);
+    f.park = p->id;
+    f.a = count > 0 ? dateToInt(date) : 0;
+    f.b = count > 1 ? dateToInt(date2) : 0;
+    writeFrame(&f, stdout);
+  } else if (command == CM_PRINT_VEHICLES) {
+    sscanf(buffer, "%s", plates);
+    f.plate = encodePlate(plates);
+    writeFrame(&f, stdout);
+  } else {
+    writeText(command, buffer);
+    if (command == CM_ADD_PARK && buffer[0]) {
+      processCommand_p(m, buffer);
+    } else if (command == CM_REMOVE_PARK) {
+      processCommand_r(m, buffer);
+    }
+  }
+}
+
+/**
+ * @brief Converts text commands to request frames, until 'q' or the end of
+ * the input.
+ */
+static void toFrames() {
+  Memory *m = malloc(sizeof(Memory));
+  char *buffer = malloc(BUF_SIZE + 1);
+  int command;
+  initializeSystem(m);
+  m->output = OUTPUT_NONE;
+  while ((command = getchar()) != EOF) {
+    if (command == CM_EXIT) {
+      Frame f = {CM_EXIT, ST_OK, 0, 0, 0, 0};
+      writeFrame(&f, stdout);
+      break;
+    }
+    readLine(buffer);
+    convertCommand(m, command, buffer);
+  }
+  cleanUp(m);
+  free(buffer);
+}
+
+/**
+ * @brief Prints a date and time.
+ *
+ * @param stamp The date and time.
+ */
+static void printStamp(Stamp stamp) {
+  char date[11], time[6];
+  intToDate(STAMP_DAY(stamp), date);
+  intToTime(STAMP_TIME(stamp), time);
+  printf(" %s %s", date, time);
+}
+
+/**
+ * @brief Prints a data frame of a response.
+ *
+ * @param f A pointer to the data frame.
+ */
+static void printData(Frame *f) {
+  char plates[9], date[11], time[6];
+  if (f->op == CM_PRINT_VEHICLES) {
+    printf("%d", f->park);
+    printStamp(f->a);
+    if (f->b != NO_STAMP) {
+      printStamp(f->b);
+    }
+  } else if (f->plate == 0) {
+    intToDate(f->a, date);
+    printf("%s " CENTS_FMT, date, CENTS_ARG((Cents)f->b));
+  } else {
+    decodePlate(f->plate, plates);
+    intToTime(STAMP_TIME(f->a), time);
+    printf("%s %s " CENTS_FMT, plates, time, CENTS_ARG((Cents)f->b));
+  }
+  printf("\n");
+}
+
+/**
+ * @brief Converts response frames to text, until the end of the input.
+ */
+static void toText() {
+  Frame f;
+  char plates[9];
+  while (readFrame(&f, stdin)) {
+    decodePlate(f.plate, plates);
+    printf("%c ", f.op);
+    if (f.status != ST_OK) {
+      printf("%s\n", f.status <= ST_OVERFLOW ? statusNames[f.status]
+                                              : "unknown");
+    } else if (f.op == CM_ADD_VEHICLE) {
+      printf("%d %s %u\n", f.park, plates, f.a);
+    } else if (f.op == CM_EXIT_VEHICLE) {
+      printf("%d %s", f.park, plates);
+      printStamp(f.a);
+      printf(" " CENTS_FMT "\n", CENTS_ARG((Cents)f.b));
+    } else if (f.op == CM_PRINT_VEHICLES || f.op == CM_GET_BILLS) {
+      uint32_t count = f.a;
+      printf("%u\n", count);
+      for (uint32_t i = 0; i < count && readFrame(&f, stdin); i++) {
+        printData(&f);
+      }
+    } else {
+      printf("%s\n", statusNames[ST_OK]);
+    }
+  }
+}
+
+/**
+ * @brief Main function of the converter.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return Returns 0, or 1 if the arguments are not valid.
+ */
+int main(int argc, char *argv[]) {
+  if (argc == 2 && strcmp(argv[1], "-b") == 0) {
+    toFrames();
+  } else if (argc == 2 && strcmp(argv[1], "-t") == 0) {
+    toText();
+  } else {
+    fprintf(stderr, "usage: %s -b|-t\n", argv[0]);
+    return 1;
+  }
+  return 0;
+}
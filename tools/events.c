@@ -0,0 +1,129 @@
+/**
+ * @file events.c
+ * @brief Reader of the event ring of the program.
+ *
+ * Maps the event ring created by `proj1 -e <name>` and writes every event
+ * published from then on to stdout as text, with parks by id, until the
+ * program closes the ring. Events are read in place from the shared memory,
+ * and the program never waits for this reader, so a reader that falls too far
+ * behind loses events, and writes `overrun <n>` with how many. Many readers
+ * can be run at once. With -o, the events still in the ring are written
+ * first, from the oldest one.
+ *
+ * Usage:
+ *   ../proj1 -e /park-events < commands.txt &
+ *   events /park-events
+ *   events -o /park-events
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "project.h"
+
+/**
+ * @brief Formats a date and time.
+ *
+ * @param stamp The date and time.
+ * @param text Where the text is written, at least 17 characters.
+ */
+static void formatStamp(Stamp stamp, char *text) {
+  char date[11], time[6];
+  intToDate(STAMP_DAY(stamp), date);
+  intToTime(STAMP_TIME(stamp), time);
+  sprintf(text, "%s %s", date, time);
+}
+
+/**
+ * @brief Formats an event, as it is in the event ring.
+ *
+ * @param e A pointer to the event.
+ * @param line Where the text is written.
+ */
+static void formatEvent(const Event *e, char *line) {
+  char plates[9], first[17], second[17];
+  decodePlate(e->plate, plates);
+  switch (e->op) {
+    case CM_ADD_VEHICLE:
+      formatStamp(e->a, first);
+      sprintf(line, "e %d %s %s %u\n", e->park, plates, first, e->b);
+      break;
+    case CM_EXIT_VEHICLE:
+      formatStamp(e->a, first);
+      formatStamp(e->b, second);
+      sprintf(line, "s %d %s %s %s " CENTS_FMT "\n", e->park, plates, first,
+              second, CENTS_ARG((Cents)e->amount));
+      break;
+    case CM_OVERSTAYS:
+      formatStamp(e->a, first);
+      formatStamp(e->b, second);
+      sprintf(line, "l %d %s %s %s\n", e->park, plates, first, second);
+      break;
+    case CM_ADD_PARK:
+      sprintf(line, "p %d %.*s %u " CENTS_FMT "\n", e->park, EVENT_NAME - 1,
+              e->name, e->a, CENTS_ARG((Cents)e->amount));
+      break;
+    default:
+      sprintf(line, "%c %d\n", e->op, e->park);
+  }
+}
+
+/**
+ * @brief Writes the events of the ring until it is closed and every event
+ * was read.
+ *
+ * @param r A pointer to the reader.
+ */
+static void readEvents(EventReader *r) {
+  struct timespec pause = {0, 1000000};
+  char line[BUF_SIZE];
+  uint64_t lost = 0;
+  const Event *e;
+  for (;;) {
+    int closed = atomic_load(&r->ring->closed);
+    if ((e = eventsPeek(r, &lost)) != NULL) {
+      formatEvent(e, line);
+    }
+    if (lost > 0) {
+      printf("overrun %lu\n", (unsigned long)lost);
+      lost = 0;
+    }
+    if (e && eventsDone(r, e)) {
+      fputs(line, stdout);
+    } else if (!e && closed) {
+      return;
+    } else if (!e) {
+      fflush(stdout);
+      nanosleep(&pause, NULL);
+    }
+  }
+}
+
+/**
+ * @brief Main function of the reader.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return Returns 0, or 1 if the arguments are not valid or the event ring
+ * cannot be mapped.
+ */
+int main(int argc, char *argv[]) {
+  EventReader r;
+  int oldest = argc == 3 && strcmp(argv[1], "-o") == 0;
+  if (argc != 2 + oldest) {
+    fprintf(stderr, "usage: %s [-o] <events>\n", argv[0]);
+    return 1;
+  }
+  if (!eventsAttach(&r, argv[argc - 1])) {
+    perror(argv[argc - 1]);
+    return 1;
+  }
+  if (oldest) {
+    r.next = r.next > r.ring->capacity ? r.next - r.ring->capacity : 0;
+  }
+  readEvents(&r);
+  eventsDetach(&r);
+  return 0;
+}
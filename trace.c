@@ -0,0 +1,132 @@
+/**
+ * @file trace.c
+ * @brief Source file for the trace of the execution of the commands.
+ *
+ * This file contains the implementation of the trace selected with the
+ * option -t. Spans are recorded around `execute`, each command, the
+ * validation of entries, exits and parks, and the functions that may take
+ * long: `removeParkRecords`, `calculateSums`, `sortList` and `billsFreeze`.
+ * A span is started with `traceBegin` and recorded with `traceEnd` into a
+ * ring allocated at start, so recording never allocates, and once the ring
+ * is full the oldest spans are overwritten. Without -t, `traceBegin` returns
+ * 0 and `traceEnd` does nothing.
+ *
+ * The ring is written as Chrome trace-event JSON, which Perfetto and
+ * chrome://tracing load, when the program ends and on command 'w'. Every
+ * span is a complete event, "ph":"X", with its start and duration in
+ * microseconds and the thread that recorded it, so nested spans are drawn
+ * one inside the other.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "project.h"
+
+static Trace *trace; /*The trace, or NULL if there is none*/
+
+static _Atomic int threads;        /*Number of threads that recorded spans*/
+static _Thread_local int thread;   /*Number of this thread, from 1, or 0*/
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return Returns the nanoseconds since some fixed point, never 0.
+ */
+static long traceClock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec + 1;
+}
+
+/**
+ * @brief Starts the trace, with its ring allocated and touched.
+ *
+ * @param path The path of the JSON file the trace is written to.
+ * @return Returns 1, or 0 if the file cannot be written.
+ */
+int traceOpen(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    return 0;
+  }
+  fclose(f);
+  trace = malloc(sizeof(Trace));
+  trace->spans = calloc(TRACE_SIZE, sizeof(Span));
+  trace->path = path;
+  trace->origin = traceClock();
+  atomic_init(&trace->head, 0);
+  return 1;
+}
+
+/**
+ * @brief Starts a span.
+ *
+ * @return Returns the time the span started, or 0 if there is no trace.
+ */
+long traceBegin(void) { return trace ? traceClock() : 0; }
+
+/**
+ * @brief Records a span that ends now.
+ *
+ * @param name The name of the span, a string that is never freed.
+ * @param start The time the span started, from `traceBegin`.
+ */
+void traceEnd(const char *name, long start) {
+  unsigned long n;
+  Span *s;
+  if (!start || !trace) {
+    return;
+  }
+  if (!thread) {
+    thread = atomic_fetch_add(&threads, 1) + 1;
+  }
+  n = atomic_fetch_add_explicit(&trace->head, 1, memory_order_relaxed);
+  s = &trace->spans[n & (TRACE_SIZE - 1)];
+  s->name = name;
+  s->start = start - trace->origin;
+  s->duration = traceClock() - start;
+  s->thread = thread;
+}
+
+/**
+ * @brief Writes the spans in the ring to the trace file, oldest first.
+ *
+ * Spans recorded by other threads while the file is written may be left out
+ * or written half recorded.
+ */
+void traceWrite(void) {
+  unsigned long head, n;
+  FILE *f;
+  if (!trace || !(f = fopen(trace->path, "w"))) {
+    return;
+  }
+  head = atomic_load(&trace->head);
+  n = head > TRACE_SIZE ? head - TRACE_SIZE : 0;
+  fputs("{\"traceEvents\":[", f);
+  for (unsigned long i = n; i < head; i++) {
+    Span *s = &trace->spans[i & (TRACE_SIZE - 1)];
+    fprintf(f,
+            "%s\n{\"name\":\"%s\",\"cat\":\"proj1\",\"ph\":\"X\",\"pid\":%d,"
+            "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            i > n ? "," : "", s->name, (int)getpid(), s->thread,
+            s->start / 1000.0, s->duration / 1000.0);
+  }
+  fputs("\n],\"displayTimeUnit\":\"ns\"}\n", f);
+  fclose(f);
+}
+
+/**
+ * @brief Writes the trace, if there is one, and ends it.
+ */
+void traceClose(void) {
+  if (trace) {
+    traceWrite();
+    free(trace->spans);
+    free(trace);
+    trace = NULL;
+  }
+}
@@ -0,0 +1,254 @@
+/**
+ * @file wheel.c
+ * @brief Source file for the detection of the vehicles that overstay.
+ *
+ * This file contains the implementation of the timer wheel, selected with the
+ * option -l, which finds the vehicles inside a park for longer than a number
+ * of minutes without looking at the others. Each entry arms a timer for the
+ * minute its stay becomes too long, and its exit cancels it in constant time.
+ * The wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots: a timer is kept at
+ * the level of the highest digit, in base WHEEL_SLOTS, where its minute and
+ * the minute of the wheel differ, in the slot of its digit there. As the
+ * clock moves, see `updateMemoryTime`, the wheel jumps to the next slot with
+ * timers, found in the bitmaps of the slots used, and moves the timers of
+ * that slot down a level, so each timer is moved at most once per level,
+ * however far the clock jumps. Timers that reach the minute of the wheel
+ * have expired: the vehicle is appended to the overstays of its park, in
+ * the order they overstayed, and published to the event ring.
+ *
+ * The wheel has its own lock, taken after the lock of the park, so any gate
+ * may arm, cancel and advance it.
+ *
+ * @author Iuri Campos - 51948
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "project.h"
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1) /*Digit of a minute at a level*/
+
+/**
+ * @brief Makes a list of timers empty.
+ *
+ * @param head A pointer to the head of the list.
+ */
+static void timerListInit(Timer *head) {
+  head->prev = head;
+  head->next = head;
+}
+
+/**
+ * @brief Appends a timer to a list of timers.
+ *
+ * @param head A pointer to the head of the list.
+ * @param t A pointer to the timer.
+ */
+static void timerListAdd(Timer *head, Timer *t) {
+  t->prev = head->prev;
+  t->next = head;
+  head->prev->next = t;
+  head->prev = t;
+}
+
+/**
+ * @brief Removes a timer from its list.
+ *
+ * @param t A pointer to the timer.
+ */
+static void timerListRemove(Timer *t) {
+  t->prev->next = t->next;
+  t->next->prev = t->prev;
+}
+
+/**
+ * @brief Creates an empty timer wheel.
+ *
+ * @param threshold The minutes a vehicle stays before it overstays.
+ * @return Returns a pointer to the new wheel.
+ */
+Wheel *wheelNew(Stamp threshold) {
+  Wheel *w = malloc(sizeof(Wheel));
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+      timerListInit(&w->slots[level][slot]);
+    }
+    w->used[level] = 0;
+  }
+  for (int i = 0; i < MAX_PARKS; i++) {
+    timerListInit(&w->overstays[i]);
+  }
+  slabInit(&w->timers, sizeof(Timer));
+  w->now = NO_STAMP;
+  w->threshold = threshold;
+  pthread_mutex_init(&w->lock, NULL);
+  return w;
+}
+
+/**
+ * @brief Finds the digit of a minute at a level of the wheel.
+ *
+ * @param stamp The minute.
+ * @param level The level.
+ * @return Returns the digit.
+ */
+static int wheelDigit(Stamp stamp, int level) {
+  return (stamp >> (level * WHEEL_BITS)) & WHEEL_MASK;
+}
+
+/**
+ * @brief Places a timer in the slot it belongs to, or in the overstays of its
+ * park if it has expired.
+ *
+ * The wheel lock is held.
+ *
+ * @param m A pointer to the Memory structure with the wheel.
+ * @param t A pointer to the timer.
+ */
+static void wheelPlace(Memory *m, Timer *t) {
+  Wheel *w = m->wheel;
+  Record *r = t->record;
+  int level, slot;
+  if (t->expires <= w->now) {
+    timerListAdd(&w->overstays[r->park], t);
+    eventsPublish(m, CM_OVERSTAYS, m->parkTable[r->park], r->plate,
+                  t->expires, r->entry, 0);
+    return;
+  }
+  level = (31 - __builtin_clz(t->expires ^ w->now)) / WHEEL_BITS;
+  slot = wheelDigit(t->expires, level);
+  timerListAdd(&w->slots[level][slot], t);
+  w->used[level] |= 1ULL << slot;
+}
+
+/**
+ * @brief Arms the timer of a vehicle that entered a park.
+ *
+ * The caller holds the lock of the vehicle.
+ *
+ * @param m A pointer to the Memory structure with the wheel.
+ * @param n A pointer to the hash table node of the vehicle.
+ * @param r A pointer to the open record of the vehicle.
+ */
+void wheelArm(Memory *m, HashNode *n, Record *r) {
+  Wheel *w = m->wheel;
+  pthread_mutex_lock(&w->lock);
+  n->timer = slabAlloc(&w->timers);
+  n->timer->record = r;
+  n->timer->expires = r->entry + w->threshold;
+  wheelPlace(m, n->timer);
+  pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * @brief Cancels the timer of a vehicle that left a park, if it has one.
+ *
+ * The timer is removed from its slot, or from the overstays of the park, and
+ * the bit of its slot is left set, to be cleared when the wheel reaches it.
+ * The caller holds the lock of the vehicle.
+ *
+ * @param m A pointer to the Memory structure with the wheel.
+ * @param n A pointer to the hash table node of the vehicle.
+ */
+void wheelCancel(Memory *m, HashNode *n) {
+  Wheel *w = m->wheel;
+  if (!n->timer) {
+    return;
+  }
+  pthread_mutex_lock(&w->lock);
+  timerListRemove(n->timer);
+  slabFree(&w->timers, n->timer);
+  pthread_mutex_unlock(&w->lock);
+  n->timer = NULL;
+}
+
+/**
+ * @brief Finds the next minute of the wheel with a slot to empty.
+ *
+ * The first level with a slot after the digit of the wheel has the earliest
+ * one, since the slots of the levels below it are all within the current
+ * slot of that level.
+ *
+ * @param w A pointer to the wheel.
+ * @param level Where the level of the slot is stored.
+ * @return Returns the minute the slot starts, or NO_STAMP if every slot is
+ * empty.
+ */
+static Stamp wheelNext(Wheel *w, int *level) {
+  for (*level = 0; *level < WHEEL_LEVELS; (*level)++) {
+    int shift = *level * WHEEL_BITS;
+    uint64_t later = w->used[*level] &
+                     ~((2ULL << wheelDigit(w->now, *level)) - 1);
+    if (later) {
+      uint64_t block = (uint64_t)w->now >> shift >> WHEEL_BITS;
+      return ((block << WHEEL_BITS) | __builtin_ctzll(later)) << shift;
+    }
+  }
+  return NO_STAMP;
+}
+
+/**
+ * @brief Moves the wheel forward to a minute, expiring the timers up to it.
+ *
+ * @param m A pointer to the Memory structure with the wheel.
+ * @param now The minute, ignored if the wheel is already past it.
+ */
+void wheelAdvance(Memory *m, Stamp now) {
+  Wheel *w = m->wheel;
+  Timer due;
+  Stamp next;
+  int level, slot;
+  pthread_mutex_lock(&w->lock);
+  while (w->now < now) {
+    next = wheelNext(w, &level);
+    if (next == NO_STAMP || next > now) {
+      w->now = now;
+      break;
+    }
+    w->now = next;
+    slot = wheelDigit(next, level);
+    w->used[level] &= ~(1ULL << slot);
+    if (w->slots[level][slot].next == &w->slots[level][slot]) {
+      continue;  // its timers were all cancelled
+    }
+    due = w->slots[level][slot];
+    due.prev->next = &due;
+    due.next->prev = &due;
+    timerListInit(&w->slots[level][slot]);
+    while (due.next != &due) {
+      Timer *t = due.next;
+      timerListRemove(t);
+      wheelPlace(m, t);
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * @brief Prints the vehicles that overstay in a park, in the order they
+ * overstayed: `<plate> <date> <time>` of their entry.
+ *
+ * @param m A pointer to the Memory structure with the wheel.
+ * @param p A pointer to the park.
+ */
+void wheelPrint(Memory *m, Park *p) {
+  Timer *head = &m->wheel->overstays[p->index];
+  char plates[9], date[11], time[6];
+  for (Timer *t = head->next; t != head; t = t->next) {
+    decodePlate(t->record->plate, plates);
+    intToDate(STAMP_DAY(t->record->entry), date);
+    intToTime(STAMP_TIME(t->record->entry), time);
+    fprintf(m->out, "%s %s %s\n", plates, date, time);
+  }
+}
+
+/**
+ * @brief Frees a timer wheel and its timers.
+ *
+ * @param w A pointer to the wheel.
+ */
+void freeWheel(Wheel *w) {
+  slabDestroy(&w->timers);
+  pthread_mutex_destroy(&w->lock);
+  free(w);
+}